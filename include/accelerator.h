@@ -1,25 +1,34 @@
 #pragma once
 
 #include "player.h"
+#include "course_object.h"
+#include "course_activation.h"
 #include "MonaEngine.hpp"
 #include "Rendering/DiffuseFlatMaterial.hpp"
 
-class Accelerator : public Mona::GameObject {
+class Accelerator : public Mona::GameObject, public CourseObject {
 public:
-	Accelerator(glm::vec3 initPos, Mona::GameObjectHandle<Player> player, float scale);
+	Accelerator(glm::vec3 initPos, Mona::GameObjectHandle<CourseActivation> activation, float scale);
 	~Accelerator();
 
 	virtual void UserStartUp(Mona::World& world) noexcept;
 
-	virtual void UserUpdate(Mona::World& world, float timeStep) noexcept;
+	virtual glm::vec3 getCoursePosition() const { return mInitPos; }
+	virtual int findContact(const std::vector<glm::vec3>& riderPositions) const;
+	virtual void applyContact(Mona::World& world, Mona::GameObjectHandle<Player>& rider);
+	virtual bool isConsumed() const { return !mIsVisible; }
+	virtual void setConsumed(bool consumed) { mIsVisible = !consumed; }
+	virtual float getSteeringWeight() const { return -0.8f; }
+	virtual float getSteeringRadius() const { return 1.5f * mScale; }
 
 private:
-	Mona::TransformHandle mTransform;
-	Mona::GameObjectHandle<Player> mPlayer;
 	glm::vec3 mInitPos;
 	float mScale;
+	Mona::GameObjectHandle<CourseActivation> mActivation;
 	float postL = 1.0f;
 
 	bool mIsVisible = true;
+
+	TrackedAllocation mTracked{ MemoryTag::GameObjects, sizeof(Accelerator) };
 };
 
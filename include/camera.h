@@ -14,6 +14,11 @@ public:
 
     virtual void UserUpdate(Mona::World& world, float timeStep) noexcept;
 
+    // Lee los controles de la cámara y la deja mirando al rider en su posición actual
+    void updateView(Mona::World& world);
+    // Con scheduled en true UserUpdate no hace nada y FrameScheduler llama updateView después de mover al rider
+    void setScheduled(bool scheduled) { mScheduled = scheduled; }
+
     void mouseMoved(Mona::World& world);
     void mouseWheelScrolled(Mona::World& world);
 
@@ -47,5 +52,9 @@ private:
     glm::dvec2 mLastMousePosition = glm::dvec2(0.0, 0.0);
     float mSensitivity = 1.0f;
 
+    bool mScheduled = false;
+
+    TrackedAllocation mTracked{ MemoryTag::GameObjects, sizeof(Camera) };
+
 };
 
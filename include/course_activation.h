@@ -0,0 +1,103 @@
+#pragma once
+
+#include "course_object.h"
+#include "player.h"
+#include "MonaEngine.hpp"
+#include <bitset>
+#include <cstdint>
+#include <vector>
+
+// Despierta los objetos de la pista que están por delante (o cerca) de algún rider y duerme el resto.
+// Los objetos se ordenan por avance en la pista, así que cada frame solo se recorre la ventana activa.
+class CourseActivation : public Mona::GameObject {
+public:
+	// Triggers que caben en un snapshot de rollback; el resto no se guarda
+	static constexpr int maxSnapshotTriggers = 128;
+	using TriggerMask = std::bitset<maxSnapshotTriggers>;
+
+	// wakeAhead/keepBehind: distancia por delante y por detrás del rider, medida a lo largo de la pista.
+	// wakeRadius: además se despierta todo lo que esté a esta distancia de un rider.
+	CourseActivation(float wakeAhead, float keepBehind, float wakeRadius, glm::vec3 courseDirection = glm::vec3(0.0f, 0.0f, -1.0f));
+	~CourseActivation();
+
+	virtual void UserStartUp(Mona::World& world) noexcept;
+
+	virtual void UserUpdate(Mona::World& world, float timeStep) noexcept;
+
+	void addRider(Mona::GameObjectHandle<Player> rider);
+	void registerObject(CourseObject* object);
+
+	const std::vector<Mona::GameObjectHandle<Player>>& getRiders() const { return mRiders; }
+	// Objetos registrados; el índice no se mantiene entre frames porque se reordenan por avance
+	int getObjectCount() const { return static_cast<int>(mEntries.size()); }
+	CourseObject* getObject(int index) const { return mEntries[index].object; }
+
+	// Con scheduled en true UserUpdate no hace nada: FrameScheduler (o RollbackSession, en cada tick)
+	// llama updateWindow y los triggers
+	void setScheduled(bool scheduled) { mScheduled = scheduled; }
+	// Con deferred en true dormir, despertar o retirar no cambia qué se dibuja hasta applyVisibility;
+	// RollbackSession lo usa mientras re-simula ticks que ya se mostraron
+	void setVisibilityDeferred(bool deferred) { mVisibilityDeferred = deferred; }
+
+	// Duerme y despierta según dónde están los riders ahora
+	void updateWindow(Mona::World& world);
+
+	// Los triggers van en tres pasos para poder repartirlos entre hilos: beginContacts fija las posiciones
+	// de los riders y retorna cuántos objetos hay que revisar, findContacts solo lee y escribe su rango,
+	// y applyContacts aplica los efectos en serie y en el orden de la pista.
+	size_t beginContacts();
+	void findContacts(size_t begin, size_t end);
+	void applyContacts(Mona::World& world);
+	// Los tres pasos seguidos en este hilo
+	void updateTriggers(Mona::World& world);
+
+	// Qué triggers están consumidos, en el orden de la lista interna (que no cambia después de registrar)
+	const TriggerMask& getConsumedMask() const { return mConsumedMask; }
+	// Vuelve al estado de consumed: solo se tocan los triggers que cambiaron. No cambia qué se dibuja,
+	// para no agregar y quitar meshes en cada rollback; eso lo hace applyVisibility al terminar de re-simular.
+	void restoreConsumed(const TriggerMask& consumed);
+	// Dibuja u oculta los objetos que quedaron pendientes (restoreConsumed o visibilidad diferida) según su estado actual
+	void applyVisibility(Mona::World& world);
+
+	int getAwakeCount() const { return static_cast<int>(mAwake.size()); }
+	int getRetiredCount() const { return mRetiredCount; }
+
+private:
+	enum class State { Asleep, Awake, Retired };
+
+	struct Entry {
+		CourseObject* object;
+		float progress;
+		State state;
+		uint32_t wantedFrame;
+		bool visibilityPending;     // el dibujo puede no calzar con state hasta applyVisibility
+	};
+
+	float progressOf(const glm::vec3& position) const { return glm::dot(position, mCourseDirection); }
+	void sortEntries();
+	void collectWindow();
+	void retire(Mona::World& world, int index);
+	void setRendered(Mona::World& world, Entry& entry, bool rendered);
+
+	float mWakeAhead;
+	float mKeepBehind;
+	float mWakeRadius;
+	glm::vec3 mCourseDirection;
+
+	std::vector<Mona::GameObjectHandle<Player>> mRiders;
+	std::vector<Entry> mEntries;
+	std::vector<int> mAwake;
+	std::vector<int> mNextAwake;
+
+	std::vector<glm::vec3> mRiderPositions;
+	std::vector<int> mContacts;     // rider que toca a cada despierto, en el orden de mAwake
+
+	TriggerMask mConsumedMask;
+	std::vector<int> mPendingVisibility;
+
+	bool mSorted = true;
+	bool mVisibilityDeferred = false;
+	bool mScheduled = false;
+	uint32_t mFrame = 0;
+	int mRetiredCount = 0;
+};
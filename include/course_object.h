@@ -0,0 +1,49 @@
+#pragma once
+
+#include "MonaEngine.hpp"
+#include <memory>
+#include <vector>
+
+class Player;
+
+// Objeto de la pista (obstáculo, acelerador, meta) manejado por CourseActivation: solo se revisa
+// y solo se dibuja mientras algún rider está cerca.
+class CourseObject {
+public:
+	virtual ~CourseObject() = default;
+
+	virtual glm::vec3 getCoursePosition() const = 0;
+
+	// Índice del primer rider que toca el objeto, o -1. Solo lee, así que CourseActivation puede
+	// revisar varios objetos a la vez en distintos hilos.
+	virtual int findContact(const std::vector<glm::vec3>& riderPositions) const = 0;
+	// Efecto del contacto sobre el rider; se aplica en serie y en el orden de la pista
+	virtual void applyContact(Mona::World& world, Mona::GameObjectHandle<Player>& rider) = 0;
+
+	// Triggers de un solo uso ya activados: se retiran para siempre
+	virtual bool isConsumed() const = 0;
+	// Lo usa el rollback para devolver un trigger al estado de un snapshot
+	virtual void setConsumed(bool consumed) = 0;
+
+	// Cuánto desvía el objeto el camino de los riders de la CPU dentro de su radio (en XZ): positivo
+	// los aleja, negativo los atrae. FlowField lo deja de considerar cuando el objeto se consume.
+	virtual float getSteeringWeight() const { return 0.0f; }
+	virtual float getSteeringRadius() const { return 0.0f; }
+
+	// Agrega o quita los meshes de la lista de dibujo
+	void setRendered(Mona::World& world, bool rendered);
+
+protected:
+	void addMeshPart(Mona::World& world, const glm::vec3& position, const glm::vec3& scale, std::shared_ptr<Mona::Mesh> mesh, std::shared_ptr<Mona::Material> material);
+
+private:
+	struct MeshPart {
+		Mona::GameObjectHandle<Mona::GameObject> object;
+		Mona::ComponentHandle<Mona::StaticMeshComponent> meshComponent;
+		std::shared_ptr<Mona::Mesh> mesh;
+		std::shared_ptr<Mona::Material> material;
+	};
+
+	std::vector<MeshPart> mParts;
+	bool mRendered = true;
+};
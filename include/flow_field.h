@@ -0,0 +1,109 @@
+#pragma once
+
+#include "mesh_navigator.h"
+#include "course_object.h"
+#include "player.h"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// Campo de direcciones sobre la huella de la pista para los riders de la CPU: en cada celda guarda
+// hacia dónde conviene ir para llegar a la meta, así que doblar cuesta una consulta a la grilla.
+// Se precalcula al cargar: el costo de cada celda sale de la pendiente del terreno, los obstáculos
+// (lo encarecen) y los gates (lo abaratan), y desde la meta se propaga el costo de llegar. La
+// dirección final mezcla la bajada de ese costo con la fuerza de deslizamiento que usa el Player.
+class FlowField {
+public:
+	// cellSize en metros; las celdas con centro más allá de finishZ (hacia -z) son la meta
+	FlowField(float cellSize = 1.0f, float finishZ = Player::finishLineZ);
+
+	// Los objetos se revisan en cada refresh; uno consumido deja de desviar el campo
+	void addObject(CourseObject* object);
+
+	// Muestrea el terreno y arma el campo completo. El muestreo, los costos y las direcciones se
+	// reparten en el ThreadPool; la propagación desde la meta es serial.
+	void build(MeshNavigator& navigator);
+
+	// Si algún objeto se consumió (o volvió por un rollback), recalcula solo las celdas cuyo camino
+	// a la meta pasaba por su zona. Retorna cuántas celdas se recalcularon.
+	size_t refresh();
+
+	// Dirección en XZ (normalizada) en la celda de (x, z); false fuera de la pista
+	bool getDirection(float x, float z, glm::vec2& direction) const {
+		int cell = cellIndex(x, z);
+		if (cell < 0 || !m_valid[cell]) return false;
+		direction = m_direction[cell];
+		return true;
+	}
+
+	// Costo de llegar a la meta desde la celda de (x, z); infinito fuera de la pista o sin camino
+	float getCost(float x, float z) const {
+		int cell = cellIndex(x, z);
+		if (cell < 0 || !m_valid[cell]) return std::numeric_limits<float>::infinity();
+		return m_cost[cell];
+	}
+
+	// Input que lleva al rider hacia la dirección del campo
+	PlayerInput steer(const glm::vec3& position, const glm::vec3& velocity) const;
+
+	bool isBuilt() const { return !m_valid.empty(); }
+	int getWidth() const { return m_width; }
+	int getDepth() const { return m_depth; }
+	double getBuildMillis() const { return m_buildMillis; }
+	size_t getLastRepairCells() const { return m_lastRepairCells; }
+
+private:
+	struct TrackedObject {
+		CourseObject* object;
+		bool consumed;
+	};
+
+	int cellIndex(float x, float z) const {
+		float fx = (x - m_minX) / m_cellSize;
+		float fz = (z - m_minZ) / m_cellSize;
+		// Escrito así para que un NaN también quede fuera
+		if (!(fx >= 0.0f && fx < m_width && fz >= 0.0f && fz < m_depth)) return -1;
+		return static_cast<int>(fz) * m_width + static_cast<int>(fx);
+	}
+	glm::vec2 cellCenter(int x, int z) const {
+		return glm::vec2(m_minX + (x + 0.5f) * m_cellSize, m_minZ + (z + 0.5f) * m_cellSize);
+	}
+
+	float computeFactor(int cell) const;
+	float edgeCost(int from, int to, float distance) const;
+	void updateFactors(int minX, int minZ, int maxX, int maxZ);
+	void updateDirections(int minX, int minZ, int maxX, int maxZ);
+	// Dijkstra desde las celdas que ya están en la cola; marca en changed el rectángulo que tocó
+	void propagate(int& minX, int& minZ, int& maxX, int& maxZ);
+	size_t repair(const glm::vec3& center, float radius);
+
+	float m_cellSize;
+	float m_finishZ;
+	float m_minX = 0.0f, m_minZ = 0.0f;
+	int m_width = 0, m_depth = 0;
+
+	std::vector<TrackedObject> m_objects;
+
+	// Por celda, fila por fila (z, luego x)
+	NavVector<uint8_t> m_valid;
+	NavVector<float> m_height;
+	NavVector<glm::vec2> m_slide;       // fuerza de deslizamiento en XZ, como en Player::simulate
+	NavVector<float> m_slope;           // grados
+	NavVector<float> m_factor;          // costo por metro recorrido dentro de la celda
+	NavVector<float> m_cost;            // costo de llegar a la meta
+	NavVector<int32_t> m_next;          // celda siguiente en ese camino, -1 en la meta o sin camino
+	NavVector<glm::vec2> m_direction;
+
+	struct QueueEntry {
+		float cost;
+		int32_t cell;
+		bool operator>(const QueueEntry& other) const { return cost > other.cost || (cost == other.cost && cell > other.cell); }
+	};
+	std::vector<QueueEntry> m_queue;    // heap de propagate
+	std::vector<int32_t> m_affected;    // celdas que repair invalidó
+	NavVector<uint8_t> m_affectedMark;
+
+	double m_buildMillis = 0.0;
+	size_t m_lastRepairCells = 0;
+};
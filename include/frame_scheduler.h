@@ -0,0 +1,175 @@
+#pragma once
+
+#include "thread_pool.h"
+#include "MonaEngine.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Fases del frame de gameplay, en el orden en que corren
+enum class FramePhase {
+	Input = 0,          // leer controles
+	Simulation,         // mover a los riders
+	Triggers,           // ventana de la pista y detección de contactos: solo lecturas
+	Events,             // aplicar los contactos y lo que modifica el mundo
+	Presentation,       // transforms, cámara, audio y efectos
+	Count
+};
+
+const char* framePhaseName(FramePhase phase);
+
+struct PhaseStats {
+	double millis = 0.0;        // promedio móvil
+	size_t items = 0;           // ítems paralelos del último frame
+	int fanOuts = 0;            // grupos del último frame que se repartieron entre hilos
+};
+
+// Tareas del frame agrupadas por fase. Dentro de una fase las tareas corren en el orden en que se
+// agregaron: las paralelas seguidas se juntan en un solo parallelFor y las seriales hacen de barrera.
+// Una tarea paralela solo escribe lo de su ítem, así que el resultado no depende de cuántos hilos hay
+// ni de cuál corrió qué. Context es lo que reciben las tareas seriales (el World en el juego); es un
+// parámetro para poder probar el orden de las fases sin motor.
+template <typename Context>
+class BasicPhaseRunner {
+public:
+	using SerialTask = std::function<void(Context& context, float timeStep)>;
+	// Sin contexto: los ítems corren en cualquier hilo y el World no es thread-safe
+	using ItemTask = std::function<void(size_t index, float timeStep)>;
+	using CountTask = std::function<size_t()>;
+
+	void addTask(FramePhase phase, SerialTask task) {
+		Task entry;
+		entry.serial = std::move(task);
+		mPhases[static_cast<int>(phase)].push_back(std::move(entry));
+	}
+
+	// count se evalúa en el hilo principal justo antes de repartir; con count <= grain corre en este hilo.
+	// task no puede llamar a parallelFor.
+	void addParallelTask(FramePhase phase, CountTask count, ItemTask task, size_t grain = 1) {
+		Task entry;
+		entry.count = std::move(count);
+		entry.item = std::move(task);
+		entry.grain = std::max<size_t>(1, grain);
+		mPhases[static_cast<int>(phase)].push_back(std::move(entry));
+	}
+
+	// Corre todas las fases en orden
+	void runFrame(Context& context, float timeStep) {
+		auto& pool = ThreadPool::GetInstance();
+		uint64_t stealsBefore = pool.getStealCount();
+		auto frameStart = Clock::now();
+
+		for (int phase = 0; phase < static_cast<int>(FramePhase::Count); phase++) {
+			runPhase(context, phase, timeStep);
+		}
+
+		mFrameMillis += (millisSince(frameStart) - mFrameMillis) * 0.1;
+		mSteals = pool.getStealCount() - stealsBefore;
+	}
+
+	const PhaseStats& getStats(FramePhase phase) const { return mStats[static_cast<int>(phase)]; }
+	double getFrameMillis() const { return mFrameMillis; }
+	uint64_t getSteals() const { return mSteals; }
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	struct Task {
+		SerialTask serial;
+		CountTask count;
+		ItemTask item;
+		size_t grain = 1;
+	};
+
+	static double millisSince(Clock::time_point start) {
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+
+	void runPhase(Context& context, int phase, float timeStep) {
+		const std::vector<Task>& tasks = mPhases[phase];
+		PhaseStats& stats = mStats[phase];
+		stats.items = 0;
+		stats.fanOuts = 0;
+		auto start = Clock::now();
+
+		size_t i = 0;
+		while (i < tasks.size()) {
+			if (tasks[i].serial) {
+				tasks[i].serial(context, timeStep);
+				i++;
+				continue;
+			}
+			size_t last = i;
+			while (last < tasks.size() && !tasks[last].serial) last++;
+			runParallel(tasks, i, last, timeStep, stats);
+			i = last;
+		}
+
+		stats.millis += (millisSince(start) - stats.millis) * 0.1;
+	}
+
+	// Tareas paralelas [first, last) de la fase en un solo parallelFor
+	void runParallel(const std::vector<Task>& tasks, size_t first, size_t last, float timeStep, PhaseStats& stats) {
+		// Los ítems de todas las tareas del grupo van en un solo rango; mOffsets[k] es donde empieza la tarea first + k
+		mOffsets.resize(last - first + 1);
+		mOffsets[0] = 0;
+		size_t grain = tasks[first].grain;
+		for (size_t k = first; k < last; k++) {
+			mOffsets[k - first + 1] = mOffsets[k - first] + tasks[k].count();
+			grain = std::min(grain, tasks[k].grain);
+		}
+		size_t total = mOffsets.back();
+		if (total == 0) return;
+
+		stats.items += total;
+		// Con pocos ítems parallelFor los corre en este hilo
+		if (total > grain && ThreadPool::GetInstance().getWorkerCount() > 1) stats.fanOuts++;
+		ThreadPool::GetInstance().parallelFor(total, grain, [&](size_t begin, size_t end) {
+			size_t k = std::upper_bound(mOffsets.begin(), mOffsets.end(), begin) - mOffsets.begin() - 1;
+			for (size_t index = begin; index < end; index++) {
+				while (index >= mOffsets[k + 1]) k++;
+				tasks[first + k].item(index - mOffsets[k], timeStep);
+			}
+		});
+	}
+
+	std::vector<Task> mPhases[static_cast<int>(FramePhase::Count)];
+	PhaseStats mStats[static_cast<int>(FramePhase::Count)];
+	double mFrameMillis = 0.0;
+	uint64_t mSteals = 0;
+
+	std::vector<size_t> mOffsets;
+};
+
+// Corre el gameplay del frame por fases fijas, en vez de depender del orden en que el motor llama UserUpdate
+class FrameScheduler : public Mona::GameObject {
+public:
+	using SerialTask = BasicPhaseRunner<Mona::World>::SerialTask;
+	using ItemTask = BasicPhaseRunner<Mona::World>::ItemTask;
+	using CountTask = BasicPhaseRunner<Mona::World>::CountTask;
+
+	FrameScheduler();
+	~FrameScheduler();
+
+	virtual void UserStartUp(Mona::World& world) noexcept;
+
+	virtual void UserUpdate(Mona::World& world, float timeStep) noexcept;
+
+	void addTask(FramePhase phase, SerialTask task) { mRunner.addTask(phase, std::move(task)); }
+	// count se evalúa en el hilo principal justo antes de repartir; con count <= grain corre en este hilo.
+	// task no puede llamar a parallelFor.
+	void addParallelTask(FramePhase phase, CountTask count, ItemTask task, size_t grain = 1) {
+		mRunner.addParallelTask(phase, std::move(count), std::move(task), grain);
+	}
+
+	const PhaseStats& getStats(FramePhase phase) const { return mRunner.getStats(phase); }
+	double getFrameMillis() const { return mRunner.getFrameMillis(); }
+	// Rangos robados entre hilos durante las fases, en el último frame
+	uint64_t getSteals() const { return mRunner.getSteals(); }
+
+private:
+	BasicPhaseRunner<Mona::World> mRunner;
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "player.h"
+#include <cstdint>
+#include <random>
+#include <vector>
+
+// Paquete de inputs: los últimos count inputs a partir de firstTick. Cada paquete repite los
+// anteriores, así que perder uno no deja huecos mientras llegue alguno de los siguientes.
+struct InputPacket {
+    static constexpr int maxInputs = 16;
+
+    uint32_t firstTick = 0;
+    uint8_t count = 0;
+    PlayerInput inputs[maxInputs];
+};
+
+// Peer remoto de mentira para probar el rollback sin red: lo que se le manda vuelve como los inputs
+// del rider remoto, con latencia, jitter y pérdida simulados. Los paquetes pueden llegar desordenados.
+class LoopbackPeer {
+public:
+    LoopbackPeer(float latencyMs, float jitterMs, float lossRate, uint32_t seed = 1);
+
+    void send(const InputPacket& packet, double nowMs);
+
+    // Agrega a out los paquetes que ya llegaron a nowMs
+    void receive(double nowMs, std::vector<InputPacket>& out);
+
+    uint64_t getSentCount() const { return mSent; }
+    uint64_t getDroppedCount() const { return mDropped; }
+
+private:
+    struct InFlight {
+        double arrivalMs;
+        InputPacket packet;
+    };
+
+    float mLatencyMs;
+    float mJitterMs;
+    float mLossRate;
+
+    std::mt19937 mRandom;
+    std::uniform_real_distribution<float> mUniform{ 0.0f, 1.0f };
+
+    std::vector<InFlight> mInFlight;
+    uint64_t mSent = 0;
+    uint64_t mDropped = 0;
+};
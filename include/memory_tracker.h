@@ -0,0 +1,128 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <new>
+#include <set>
+#include <string>
+
+// Subsistemas a los que se les lleva la cuenta de memoria
+enum class MemoryTag : int {
+    Navigator = 0,
+    Textures,
+    Meshes,
+    Audio,
+    GameObjects,
+    Effects,        // partículas y surcos de nieve
+    Count
+};
+
+const char* memoryTagName(MemoryTag tag);
+// Subsistemas cuya cuenta sale de estimaciones sobre los archivos (track*File) y no de reservas medidas:
+// lo que reserva el motor por dentro, como la escena de Assimp al cargar un mesh, no se ve
+bool memoryTagIsEstimate(MemoryTag tag);
+
+struct MemoryStats {
+    size_t liveBytes = 0;
+    size_t peakBytes = 0;
+    uint64_t allocations = 0;
+    uint64_t frees = 0;
+    size_t budgetBytes = 0;     // 0: sin presupuesto
+};
+
+// Contadores de memoria por subsistema. Los registros son atómicos, así que se pueden hacer
+// desde los hilos del ThreadPool; los presupuestos se revisan desde el hilo principal.
+class MemoryTracker {
+public:
+    static MemoryTracker& GetInstance();
+
+    void recordAllocation(MemoryTag tag, size_t bytes);
+    void recordFree(MemoryTag tag, size_t bytes);
+
+    MemoryStats getStats(MemoryTag tag) const;
+
+    void setBudget(MemoryTag tag, size_t bytes);
+
+    // Avisa una vez cada vez que un subsistema cruza su presupuesto. Retorna cuántos están excedidos.
+    int checkBudgets();
+
+    bool dumpToFile(const std::string& filename) const;
+
+    // Estimaciones para memoria que maneja el motor: textura PNG decodificada a RGBA y datos PCM de un WAV.
+    // Cada archivo se cuenta una sola vez aunque se cargue varias veces, igual que en los managers del motor.
+    size_t trackTextureFile(const std::filesystem::path& path);
+    size_t trackAudioFile(const std::filesystem::path& path);
+    // Para meshes el tamaño depende del formato, así que lo calcula quien carga (p. ej. estimateObjMeshBytes)
+    size_t trackMeshFile(const std::filesystem::path& path, size_t bytes);
+
+private:
+    MemoryTracker() = default;
+
+    bool markTracked(const std::filesystem::path& path);
+
+    struct Counters {
+        std::atomic<size_t> live = 0;
+        std::atomic<size_t> peak = 0;
+        std::atomic<uint64_t> allocations = 0;
+        std::atomic<uint64_t> frees = 0;
+        size_t budget = 0;
+        bool overBudget = false;
+    };
+
+    std::array<Counters, static_cast<int>(MemoryTag::Count)> m_counters;
+
+    std::mutex m_pathsMutex;
+    std::set<std::string> m_trackedPaths;
+};
+
+
+// Allocator para contenedores estándar que anota lo que reserva en el subsistema Tag
+template <typename T, MemoryTag Tag>
+struct TrackingAllocator {
+    using value_type = T;
+
+    template <typename U>
+    struct rebind { using other = TrackingAllocator<U, Tag>; };
+
+    TrackingAllocator() noexcept = default;
+    template <typename U>
+    TrackingAllocator(const TrackingAllocator<U, Tag>&) noexcept {}
+
+    T* allocate(size_t n) {
+        T* p = static_cast<T*>(::operator new(n * sizeof(T)));
+        MemoryTracker::GetInstance().recordAllocation(Tag, n * sizeof(T));
+        return p;
+    }
+
+    void deallocate(T* p, size_t n) noexcept {
+        MemoryTracker::GetInstance().recordFree(Tag, n * sizeof(T));
+        ::operator delete(p);
+    }
+
+    template <typename U>
+    bool operator==(const TrackingAllocator<U, Tag>&) const noexcept { return true; }
+    template <typename U>
+    bool operator!=(const TrackingAllocator<U, Tag>&) const noexcept { return false; }
+};
+
+
+// Miembro que anota el tamaño del objeto que lo contiene mientras éste vive
+class TrackedAllocation {
+public:
+    TrackedAllocation(MemoryTag tag, size_t bytes) : m_tag(tag), m_bytes(bytes) {
+        MemoryTracker::GetInstance().recordAllocation(m_tag, m_bytes);
+    }
+    TrackedAllocation(const TrackedAllocation& other) : TrackedAllocation(other.m_tag, other.m_bytes) {}
+    TrackedAllocation& operator=(const TrackedAllocation&) = delete;
+    ~TrackedAllocation() {
+        MemoryTracker::GetInstance().recordFree(m_tag, m_bytes);
+    }
+
+private:
+    MemoryTag m_tag;
+    size_t m_bytes;
+};
@@ -1,101 +1,130 @@
 #pragma once
 
-#include <stdexcept>
+#include <iostream>
+#include <limits>
 #include <string>
-#include <assimp/Importer.hpp>
-#include <assimp/scene.h>
-#include <assimp/postprocess.h>
-#include <glm/glm.hpp>
-#include <unordered_map>
 #include <vector>
+#include "quad.h"
+#include "navigator_backends.h"
+#include "snow_deformation.h"
 
 
-bool isPointInTriangleXZ(const glm::vec2& p, const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2);
-float interpolateHeightInTriangle(const glm::vec2& p, const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2);
-
+// Caras del archivo y cuántas se descartaron al armar los quads
+struct QuadLoadReport {
+    size_t faces = 0;
+    size_t quads = 0;
+    size_t nonQuadFaces = 0;
+    size_t nanFaces = 0;
+    size_t badIndexFaces = 0;
+    size_t malformedNumbers = 0;   // números ilegibles en el archivo; sus caras caen en nanFaces
 
+    size_t dropped() const { return nonQuadFaces + nanFaces + badIndexFaces; }
+};
 
-class Quad {
-public:
-    glm::vec3 v0, v1, v2, v3; // Vértices del quad
+// Lee el archivo (OBJ con el lector propio, otros formatos con Assimp) y arma los quads del terreno, escalados por scale
+std::vector<Quad*> loadQuadsFromFile(const std::string& filename, float scale, QuadLoadReport* report = nullptr);
 
-    Quad() = default;
 
-    Quad(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, const glm::vec3& d) {
-        std::vector<glm::vec3> vertices = { a, b, c, d };
-        orderVerticesCCW(vertices);
-        v0 = vertices[0];
-        v1 = vertices[1];
-        v2 = vertices[2];
-        v3 = vertices[3];
-    }
 
-    // Calcular la altura en el punto (x, z) si el quad es un plano
-    float getHeightAt(float x, float z) const {
-        // Calcular el vector normal del plano usando v0, v1 y v2
-        glm::vec3 normal = glm::normalize(glm::cross(v1 - v0, v2 - v0));
-
-        // Ecuación del plano: Ax + By + Cz + D = 0
-        // Desglosamos en A, B, C y calculamos D usando uno de los vértices (v0)
-        float A = normal.x;
-        float B = normal.y;
-        float C = normal.z;
-        float D = -(A * v0.x + B * v0.y + C * v0.z);
-
-        // Usando la ecuación del plano para resolver y en función de x y z
-        // y = -(Ax + Cz + D) / B
-        if (B == 0) {
-            throw std::runtime_error("Plano paralelo al eje Y; la altura no está definida.");
-        }
-        return -(A * x + C * z + D) / B;
-    }
+// Front end del navegador. El backend es un parámetro de template, así que cada consulta es una
+// llamada directa (normalmente inlineada) al backend elegido, sin dispatch virtual.
+template <typename Backend>
+class BasicMeshNavigator {
+    public:
+    BasicMeshNavigator(std::string filename, float scale) : m_filename(filename), m_scale(scale) {}
+    ~BasicMeshNavigator() = default;
 
-    glm::vec3 calculateQuadNormal() const {
-        // Crear dos vectores a partir de los vértices del quad
-        glm::vec3 edge1 = v1 - v0;
-        glm::vec3 edge2 = v3 - v0;
+    std::string m_filename;
 
-        // Calcular la normal usando el producto cruzado de los dos vectores
-        glm::vec3 normal = glm::normalize(glm::cross(edge1, edge2));
-        return normal;
-    }
+    std::vector<Quad*> quads;
 
-private:
-    void orderVerticesCCW(std::vector<glm::vec3>& vertices) {
-        // Calcula el centro del quad en el plano XZ
-        glm::vec3 center(0.0f);
-        for (const auto& v : vertices) {
-            center += v;
+    void loadMeshToMap(const std::string& filename) {
+        quads = loadQuadsFromFile(filename, m_scale, &m_loadReport);
+        if (m_loadReport.malformedNumbers > 0) {
+            std::cout << filename << ": " << m_loadReport.malformedNumbers << " malformed numbers" << std::endl;
+        }
+        if (m_loadReport.dropped() > 0) {
+            // Las caras descartadas quedan como hoyos en el terreno; CourseValidator muestra dónde
+            std::cout << filename << ": dropped " << m_loadReport.dropped() << " of " << m_loadReport.faces << " faces ("
+                << m_loadReport.nonQuadFaces << " not quads, " << m_loadReport.nanFaces << " with NaN, "
+                << m_loadReport.badIndexFaces << " with bad indices)" << std::endl;
         }
-        center /= vertices.size();
-
-        // Calcula los ángulos de cada vértice respecto al centro en el plano XZ
-        std::sort(vertices.begin(), vertices.end(), [&center](const glm::vec3& a, const glm::vec3& b) {
-            float angleA = atan2(a.z - center.z, a.x - center.x);
-            float angleB = atan2(b.z - center.z, b.x - center.x);
-            return angleA < angleB; // Orden CCW
-            });
+        m_backend.build(quads);
     }
-};
-
-float getHeightInQuad(const glm::vec2& positionXZ, Quad* quad);
 
+    const QuadLoadReport& getLoadReport() const { return m_loadReport; }
 
+    Quad* getQuadAtPosition(float x, float z) {
+        return m_backend.findQuad(x, z);
+    }
 
-class MeshNavigator {
-    public:
-    MeshNavigator(std::string filename, float scale);
-    ~MeshNavigator() = default;
+    // Retorna false si (x, z) cae fuera del terreno
+    bool sampleGround(float x, float z, GroundSample& sample) {
+        if (!m_backend.sample(x, z, sample)) return false;
+        if (m_overlay != nullptr) sample.height += m_overlay->getHeightDelta(x, z);
+        return true;
+    }
 
-    std::string m_filename;
+    // Consulta en lote: outHeights[i] queda en NaN si el punto i cae fuera del terreno o sobre un quad
+    // vertical. quadHints[i] es el quad de la consulta anterior del mismo punto (o nullptr) y se
+    // actualiza; si el punto sigue dentro de él no se busca en el backend. Solo se usa el plano del
+    // quad, así que la altura es la misma con cualquier backend.
+    void sampleHeights(const float* x, const float* z, float* outHeights, Quad** quadHints, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            Quad* quad = quadHints[i];
+            if (quad == nullptr || !isPointInQuadXZ(glm::vec2(x[i], z[i]), *quad)) {
+                quad = m_backend.findQuad(x[i], z[i]);
+                quadHints[i] = quad;
+            }
+            outHeights[i] = std::numeric_limits<float>::quiet_NaN();
+            if (quad == nullptr) continue;
+            try {
+                // Corre en los hilos del ThreadPool: una excepción que se escape terminaría el juego
+                outHeights[i] = quad->getHeightAt(x[i], z[i]);
+            }
+            catch (const std::runtime_error&) {
+                // Quad vertical: la partícula queda sin suelo, igual que una celda de FlowField
+                continue;
+            }
+            if (m_overlay != nullptr) outHeights[i] += m_overlay->getHeightDelta(x[i], z[i]);
+        }
+    }
 
-    std::vector<Quad*> quads;
+    // Surcos en la nieve que se suman a la altura de todas las consultas; nullptr para desactivarlos
+    void setOverlay(SnowDeformation* overlay) { m_overlay = overlay; }
+    SnowDeformation* getOverlay() { return m_overlay; }
 
-    void loadMeshToMap(const std::string& filename);
-    Quad* getQuadAtPosition(float x, float z);
+    Backend& getBackend() { return m_backend; }
 
     float m_scale;
 
+    private:
+    Backend m_backend;
+    QuadLoadReport m_loadReport;
+    SnowDeformation* m_overlay = nullptr;
 };
 
 
+// El backend se elige con la opción SNOWBOARDING_NAV_BACKEND de CMake
+#if defined(SNOWBOARDING_NAV_BACKEND_HEIGHTFIELD)
+using SelectedNavBackend = HeightfieldNavBackend;
+#elif defined(SNOWBOARDING_NAV_BACKEND_LINEAR)
+using SelectedNavBackend = LinearNavBackend;
+#else
+using SelectedNavBackend = GridNavBackend;
+#endif
+
+// Con SNOWBOARDING_NAV_VALIDATE cada consulta también se corre en el backend de referencia
+// (SNOWBOARDING_NAV_VALIDATE_REFERENCE, lineal por defecto) y se reportan las diferencias
+#if defined(SNOWBOARDING_NAV_VALIDATE)
+#if defined(SNOWBOARDING_NAV_REFERENCE_HEIGHTFIELD)
+using ReferenceNavBackend = HeightfieldNavBackend;
+#elif defined(SNOWBOARDING_NAV_REFERENCE_GRID)
+using ReferenceNavBackend = GridNavBackend;
+#else
+using ReferenceNavBackend = LinearNavBackend;
+#endif
+using MeshNavigator = BasicMeshNavigator<ValidatingNavBackend<SelectedNavBackend, ReferenceNavBackend>>;
+#else
+using MeshNavigator = BasicMeshNavigator<SelectedNavBackend>;
+#endif
@@ -0,0 +1,360 @@
+#pragma once
+
+#include "memory_tracker.h"
+#include "quad.h"
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+// Backends de consulta para MeshNavigator. Todos exponen la misma interfaz (build, findQuad, sample)
+// y se eligen en tiempo de compilación, así que las consultas no pasan por dispatch virtual.
+// Las consultas se pueden hacer desde varios hilos a la vez una vez terminado build.
+
+
+// Arreglos internos de los backends, contados en MemoryTag::Navigator
+template <typename T>
+using NavVector = std::vector<T, TrackingAllocator<T, MemoryTag::Navigator>>;
+
+
+// Caja en el plano XZ de un quad, precalculada para no rehacer los min/max en cada consulta
+struct QuadBoundsXZ {
+    float minx, maxx, minz, maxz;
+
+    bool contains(float x, float z) const {
+        return (minx <= x && x <= maxx) && (minz <= z && z <= maxz);
+    }
+};
+
+QuadBoundsXZ computeQuadBoundsXZ(const Quad& quad);
+
+// Altura y normal tomadas del plano del quad, tal como las usa la física del Player
+inline bool sampleQuadPlane(Quad* quad, float x, float z, GroundSample& sample) {
+    sample.quad = quad;
+    sample.height = quad->getHeightAt(x, z);
+    sample.normal = quad->calculateQuadNormal();
+    return true;
+}
+
+
+// Recorre todos los quads en orden y retorna el primero que contiene el punto; si ninguno lo contiene
+// (un punto justo en el borde), el primero cuya caja lo contiene, que era el comportamiento original.
+// Sirve de referencia para validar a los demás.
+class LinearNavBackend {
+public:
+    static constexpr const char* name = "linear";
+
+    void build(const std::vector<Quad*>& quads);
+
+    Quad* findQuad(float x, float z) const {
+        Quad* firstInBounds = nullptr;
+        for (size_t i = 0; i < m_bounds.size(); i++) {
+            if (!m_bounds[i].contains(x, z)) continue;
+            // Las cajas de quads vecinos se solapan: la caja sola puede elegir al vecino
+            if (isPointInQuadXZ(glm::vec2(x, z), *m_quads[i])) return m_quads[i];
+            if (firstInBounds == nullptr) firstInBounds = m_quads[i];
+        }
+        return firstInBounds;
+    }
+
+    bool sample(float x, float z, GroundSample& sample) const {
+        Quad* quad = findQuad(x, z);
+        if (quad == nullptr) return false;
+        return sampleQuadPlane(quad, x, z, sample);
+    }
+
+private:
+    NavVector<Quad*> m_quads;
+    NavVector<QuadBoundsXZ> m_bounds;
+};
+
+
+// Grilla uniforme en XZ donde cada celda guarda (en orden ascendente) los quads cuya caja la toca.
+// Como se revisan en el mismo orden que el recorrido lineal, el quad encontrado es el mismo.
+class GridNavBackend {
+public:
+    static constexpr const char* name = "grid";
+
+    void build(const std::vector<Quad*>& quads);
+
+    Quad* findQuad(float x, float z) const {
+        int cell = cellIndex(x, z);
+        if (cell < 0) return nullptr;
+        Quad* firstInBounds = nullptr;
+        for (uint32_t i = m_cellStart[cell]; i < m_cellStart[cell + 1]; i++) {
+            uint32_t q = m_cellQuads[i];
+            if (!m_bounds[q].contains(x, z)) continue;
+            if (isPointInQuadXZ(glm::vec2(x, z), *m_quads[q])) return m_quads[q];
+            if (firstInBounds == nullptr) firstInBounds = m_quads[q];
+        }
+        return firstInBounds;
+    }
+
+    bool sample(float x, float z, GroundSample& sample) const {
+        Quad* quad = findQuad(x, z);
+        if (quad == nullptr) return false;
+        return sampleQuadPlane(quad, x, z, sample);
+    }
+
+    // Llama f(quad) por cada quad cuya caja contiene (x, z), en el mismo orden en que los revisa findQuad
+    template <typename F>
+    void forEachCandidate(float x, float z, F&& f) const {
+        int cell = cellIndex(x, z);
+        if (cell < 0) return;
+        for (uint32_t i = m_cellStart[cell]; i < m_cellStart[cell + 1]; i++) {
+            uint32_t q = m_cellQuads[i];
+            if (m_bounds[q].contains(x, z)) f(m_quads[q]);
+        }
+    }
+
+    const QuadBoundsXZ& getCourseBounds() const { return m_courseBounds; }
+    float getCellSize() const { return m_cellSize; }
+
+private:
+    int cellIndex(float x, float z) const {
+        float fx = (x - m_courseBounds.minx) * m_invCellSize;
+        float fz = (z - m_courseBounds.minz) * m_invCellSize;
+        // Escrito así para que un NaN también quede fuera de la grilla
+        if (!(fx >= 0.0f && fx < m_cols && fz >= 0.0f && fz < m_rows)) return -1;
+        return static_cast<int>(fz) * m_cols + static_cast<int>(fx);
+    }
+
+    NavVector<Quad*> m_quads;
+    NavVector<QuadBoundsXZ> m_bounds;
+    NavVector<uint32_t> m_cellStart;
+    NavVector<uint32_t> m_cellQuads;
+
+    QuadBoundsXZ m_courseBounds = { 0.0f, 0.0f, 0.0f, 0.0f };
+    float m_cellSize = 1.0f;
+    float m_invCellSize = 1.0f;
+    int m_cols = 0;
+    int m_rows = 0;
+};
+
+
+// Heightfield regular remuestreado desde los quads: la altura se interpola bilinealmente entre
+// los nodos y la normal se guarda por celda. Es el más rápido, pero aproxima cerca de los bordes.
+class HeightfieldNavBackend {
+public:
+    static constexpr const char* name = "heightfield";
+
+    // subdivisions: nodos del heightfield por cada celda de la grilla de quads
+    HeightfieldNavBackend(int subdivisions = 2) : m_subdivisions(subdivisions) {}
+
+    void build(const std::vector<Quad*>& quads);
+
+    Quad* findQuad(float x, float z) const {
+        int cell = cellIndex(x, z);
+        if (cell < 0) return nullptr;
+        return resolveQuad(cell, x, z);
+    }
+
+    bool sample(float x, float z, GroundSample& sample) const {
+        float fx = (x - m_originX) * m_invCellSize;
+        float fz = (z - m_originZ) * m_invCellSize;
+        if (!(fx >= 0.0f && fx < m_cols && fz >= 0.0f && fz < m_rows)) return false;
+
+        int cx = static_cast<int>(fx);
+        int cz = static_cast<int>(fz);
+        int cell = cz * m_cols + cx;
+        Quad* quad = resolveQuad(cell, x, z);
+        if (quad == nullptr) return false;
+
+        int stride = m_cols + 1;
+        const float* h = &m_heights[cz * stride + cx];
+        float h00 = h[0], h10 = h[1], h01 = h[stride], h11 = h[stride + 1];
+
+        sample.quad = quad;
+        sample.normal = m_cellNormal[cell];
+        if (std::isnan(h00) || std::isnan(h10) || std::isnan(h01) || std::isnan(h11)) {
+            // Celda en el borde del terreno: no hay cuatro nodos válidos, se usa el plano del quad
+            sample.height = quad->getHeightAt(x, z);
+        }
+        else {
+            float tx = fx - cx;
+            float tz = fz - cz;
+            float top = h00 + (h10 - h00) * tx;
+            float bottom = h01 + (h11 - h01) * tx;
+            sample.height = top + (bottom - top) * tz;
+        }
+        return true;
+    }
+
+private:
+    // El quad de la celda es el de su centro; cerca de un borde el punto puede caer en el vecino,
+    // y entonces se busca en la grilla de quads para dar el mismo quad que los otros backends
+    Quad* resolveQuad(int cell, float x, float z) const {
+        Quad* quad = m_cellQuad[cell];
+        if (m_cellInside[cell]) return quad;
+        if (quad != nullptr && isPointInQuadXZ(glm::vec2(x, z), *quad)) return quad;
+        return m_grid.findQuad(x, z);
+    }
+
+    int cellIndex(float x, float z) const {
+        float fx = (x - m_originX) * m_invCellSize;
+        float fz = (z - m_originZ) * m_invCellSize;
+        if (!(fx >= 0.0f && fx < m_cols && fz >= 0.0f && fz < m_rows)) return -1;
+        return static_cast<int>(fz) * m_cols + static_cast<int>(fx);
+    }
+
+    int m_subdivisions;
+    GridNavBackend m_grid;
+    NavVector<float> m_heights;       // (m_cols + 1) * (m_rows + 1) nodos, NaN donde no hay suelo
+    NavVector<glm::vec3> m_cellNormal;
+    NavVector<Quad*> m_cellQuad;
+    NavVector<uint8_t> m_cellInside;  // la celda entera cae dentro de su quad: no hace falta revisar el punto
+
+    float m_originX = 0.0f;
+    float m_originZ = 0.0f;
+    float m_invCellSize = 1.0f;
+    int m_cols = 0;
+    int m_rows = 0;
+};
+
+
+struct NavValidationReport {
+    uint64_t queries = 0;
+    uint64_t presenceMismatches = 0;   // uno encontró suelo y el otro no
+    uint64_t heightMismatches = 0;
+    uint64_t normalMismatches = 0;
+    uint64_t quadQueries = 0;
+    uint64_t quadMismatches = 0;       // findQuad dio quads distintos y sus planos no coinciden en el punto
+    float maxHeightError = 0.0f;
+    float maxNormalErrorDegrees = 0.0f;
+};
+
+// Corre dos backends sobre las mismas consultas y reporta cuando difieren en el quad, la altura o la normal.
+// El resultado que se retorna siempre es el del backend principal. Los contadores son atómicos para no
+// serializar las consultas paralelas; solo el log toma un mutex, y solo hasta maxLogged mensajes.
+template <typename Primary, typename Reference>
+class ValidatingNavBackend {
+public:
+    static constexpr const char* name = "validating";
+
+    ValidatingNavBackend(float heightTolerance = 0.01f, float normalToleranceDegrees = 1.0f, int maxLogged = 20) :
+        m_heightTolerance(heightTolerance), m_normalToleranceDegrees(normalToleranceDegrees), m_maxLogged(maxLogged) {}
+
+    void build(const std::vector<Quad*>& quads) {
+        m_primary.build(quads);
+        m_reference.build(quads);
+        m_queries = 0;
+        m_presenceMismatches = 0;
+        m_heightMismatches = 0;
+        m_normalMismatches = 0;
+        m_quadQueries = 0;
+        m_quadMismatches = 0;
+        m_maxHeightError = 0.0f;
+        m_maxNormalErrorDegrees = 0.0f;
+    }
+
+    Quad* findQuad(float x, float z) {
+        Quad* primary = m_primary.findQuad(x, z);
+        Quad* reference = m_reference.findQuad(x, z);
+        compareQuads(x, z, primary, reference);
+        return primary;
+    }
+
+    bool sample(float x, float z, GroundSample& sample) {
+        GroundSample reference;
+        bool hasPrimary = m_primary.sample(x, z, sample);
+        bool hasReference = m_reference.sample(x, z, reference);
+        compare(x, z, hasPrimary, sample, hasReference, reference);
+        return hasPrimary;
+    }
+
+    // Foto de los contadores; con consultas en curso cada campo puede venir de un instante algo distinto
+    NavValidationReport getReport() const {
+        NavValidationReport report;
+        report.queries = m_queries.load(std::memory_order_relaxed);
+        report.presenceMismatches = m_presenceMismatches.load(std::memory_order_relaxed);
+        report.heightMismatches = m_heightMismatches.load(std::memory_order_relaxed);
+        report.normalMismatches = m_normalMismatches.load(std::memory_order_relaxed);
+        report.quadQueries = m_quadQueries.load(std::memory_order_relaxed);
+        report.quadMismatches = m_quadMismatches.load(std::memory_order_relaxed);
+        report.maxHeightError = m_maxHeightError.load(std::memory_order_relaxed);
+        report.maxNormalErrorDegrees = m_maxNormalErrorDegrees.load(std::memory_order_relaxed);
+        return report;
+    }
+    Primary& getPrimary() { return m_primary; }
+    Reference& getReference() { return m_reference; }
+
+private:
+    static void updateMax(std::atomic<float>& target, float value) {
+        float current = target.load(std::memory_order_relaxed);
+        while (value > current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+    }
+
+    void compareQuads(float x, float z, Quad* primary, Quad* reference) {
+        m_quadQueries.fetch_add(1, std::memory_order_relaxed);
+        if ((primary == nullptr) != (reference == nullptr)) {
+            m_presenceMismatches.fetch_add(1, std::memory_order_relaxed);
+            log(x, z, "presencia de quad", primary != nullptr ? 1.0f : 0.0f, reference != nullptr ? 1.0f : 0.0f);
+            return;
+        }
+        // En un borde compartido ambos quads contienen el punto; solo importa si dan otra altura
+        if (primary == reference || primary == nullptr) return;
+        float primaryHeight = primary->getHeightAt(x, z);
+        float referenceHeight = reference->getHeightAt(x, z);
+        if (std::abs(primaryHeight - referenceHeight) > m_heightTolerance) {
+            m_quadMismatches.fetch_add(1, std::memory_order_relaxed);
+            log(x, z, "quad (altura del plano)", primaryHeight, referenceHeight);
+        }
+    }
+
+    void compare(float x, float z, bool hasPrimary, const GroundSample& primary, bool hasReference, const GroundSample& reference) {
+        m_queries.fetch_add(1, std::memory_order_relaxed);
+        if (hasPrimary != hasReference) {
+            m_presenceMismatches.fetch_add(1, std::memory_order_relaxed);
+            log(x, z, "presencia de suelo", hasPrimary ? 1.0f : 0.0f, hasReference ? 1.0f : 0.0f);
+            return;
+        }
+        if (!hasPrimary) return;
+
+        float heightError = std::abs(primary.height - reference.height);
+        updateMax(m_maxHeightError, heightError);
+        if (heightError > m_heightTolerance) {
+            m_heightMismatches.fetch_add(1, std::memory_order_relaxed);
+            log(x, z, "altura", primary.height, reference.height);
+        }
+
+        float cosAngle = std::clamp(glm::dot(primary.normal, reference.normal), -1.0f, 1.0f);
+        float normalError = glm::degrees(std::acos(cosAngle));
+        updateMax(m_maxNormalErrorDegrees, normalError);
+        if (normalError > m_normalToleranceDegrees) {
+            m_normalMismatches.fetch_add(1, std::memory_order_relaxed);
+            log(x, z, "normal (grados)", normalError, 0.0f);
+        }
+    }
+
+    void log(float x, float z, const char* what, float primaryValue, float referenceValue) {
+        // Revisión sin lock: pasado el límite las diferencias solo se cuentan
+        if (m_logged.load(std::memory_order_relaxed) >= m_maxLogged) return;
+        std::lock_guard<std::mutex> lock(m_logMutex);
+        if (m_logged.load(std::memory_order_relaxed) >= m_maxLogged) return;
+        int logged = m_logged.fetch_add(1, std::memory_order_relaxed) + 1;
+        std::cout << "[nav " << Primary::name << " vs " << Reference::name << "] " << what
+            << " difiere en (" << x << ", " << z << "): " << primaryValue << " vs " << referenceValue << std::endl;
+        if (logged == m_maxLogged) {
+            std::cout << "[nav] demasiadas diferencias, no se reportan más" << std::endl;
+        }
+    }
+
+    Primary m_primary;
+    Reference m_reference;
+
+    std::atomic<uint64_t> m_queries{0};
+    std::atomic<uint64_t> m_presenceMismatches{0};
+    std::atomic<uint64_t> m_heightMismatches{0};
+    std::atomic<uint64_t> m_normalMismatches{0};
+    std::atomic<uint64_t> m_quadQueries{0};
+    std::atomic<uint64_t> m_quadMismatches{0};
+    std::atomic<float> m_maxHeightError{0.0f};
+    std::atomic<float> m_maxNormalErrorDegrees{0.0f};
+    std::mutex m_logMutex;
+
+    float m_heightTolerance;
+    float m_normalToleranceDegrees;
+    int m_maxLogged;
+    std::atomic<int> m_logged{0};
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "memory_tracker.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+// Lector de OBJ para el subconjunto que usan nuestros assets: registros v, vt, vn y f con
+// triángulos o quads. Ignora el resto (o, mtllib, usemtl, s, comentarios).
+
+// Índices de una esquina de cara, ya en base 0; -1 si el registro no trae ese atributo
+struct ObjIndex {
+    int32_t position = -1;
+    int32_t texcoord = -1;
+    int32_t normal = -1;
+};
+
+struct ObjFace {
+    uint8_t count = 0;      // 3 o 4
+    ObjIndex corners[4];
+};
+
+// Arreglos del parser, contados en el subsistema Tag mientras viven
+template <typename T, MemoryTag Tag = MemoryTag::Meshes>
+using ObjVector = std::vector<T, TrackingAllocator<T, Tag>>;
+
+// Tag elige a qué subsistema se le cuenta el parse: el de las mallas del motor o el del navegador
+template <MemoryTag Tag>
+struct BasicObjData {
+    ObjVector<glm::vec3, Tag> positions;
+    ObjVector<glm::vec2, Tag> texcoords;
+    ObjVector<glm::vec3, Tag> normals;
+    ObjVector<ObjFace, Tag> faces;
+    size_t skippedFaces = 0;    // caras con menos de 3 o más de 4 vértices
+    size_t malformedNumbers = 0;    // números que no se pudieron leer; quedan en NaN
+};
+
+using ObjData = BasicObjData<MemoryTag::Meshes>;
+
+// Mapea el archivo a memoria y lo parsea en paralelo. Lanza std::runtime_error si no se puede abrir.
+// Instanciado para MemoryTag::Meshes y MemoryTag::Navigator.
+template <MemoryTag Tag = MemoryTag::Meshes>
+BasicObjData<Tag> readObjFile(const std::string& filename);
+
+// Parsea un OBJ que ya está en memoria, dividiéndolo en trozos que terminan en fin de línea
+template <MemoryTag Tag = MemoryTag::Meshes>
+BasicObjData<Tag> parseObj(const char* data, size_t size);
+
+struct ObjFaceCounts {
+    size_t faces = 0;           // solo las de 3 o 4 vértices
+    size_t corners = 0;
+    size_t triangles = 0;
+};
+
+// Cuenta caras y esquinas sin armar los arreglos: sirve para estimar memoria sin pagar el parse completo
+ObjFaceCounts countObjFaces(const std::string& filename);
+
+// Memoria que ocupa el OBJ una vez cargado por el motor, para MemoryTracker::trackMeshFile
+size_t estimateObjMeshBytes(const std::string& filename);
@@ -1,24 +1,34 @@
 #pragma once
 
 #include "player.h"
+#include "course_object.h"
+#include "course_activation.h"
 #include "MonaEngine.hpp"
 #include "Rendering/DiffuseFlatMaterial.hpp"
 
-class Obstacle : public Mona::GameObject {
+class Obstacle : public Mona::GameObject, public CourseObject {
 public:
-	Obstacle(glm::vec3 initPos, Mona::GameObjectHandle<Player> player, float scale);
+	Obstacle(glm::vec3 initPos, Mona::GameObjectHandle<CourseActivation> activation, float scale);
 	~Obstacle();
 
 	virtual void UserStartUp(Mona::World& world) noexcept;
 
-	virtual void UserUpdate(Mona::World& world, float timeStep) noexcept;
+	virtual glm::vec3 getCoursePosition() const { return mInitPos; }
+	virtual int findContact(const std::vector<glm::vec3>& riderPositions) const;
+	virtual void applyContact(Mona::World& world, Mona::GameObjectHandle<Player>& rider);
+	virtual bool isConsumed() const { return !mIsVisible; }
+	virtual void setConsumed(bool consumed) { mIsVisible = !consumed; }
+	// Chocarlo detiene al rider por tres segundos: se rodea con margen
+	virtual float getSteeringWeight() const { return 6.0f; }
+	virtual float getSteeringRadius() const { return 3.0f * mScale; }
 
 private:
-	Mona::TransformHandle mTransform;
-	Mona::GameObjectHandle<Player> mPlayer;
 	glm::vec3 mInitPos;
 	float mScale;
+	Mona::GameObjectHandle<CourseActivation> mActivation;
 
 	bool mIsVisible = true;
+
+	TrackedAllocation mTracked{ MemoryTag::GameObjects, sizeof(Obstacle) };
 };
 
@@ -1,32 +1,102 @@
 #pragma once
 
 #include "mesh_navigator.h"
+#include "voice_manager.h"
 #include "MonaEngine.hpp"
 #include "Rendering/DiffuseFlatMaterial.hpp"
 //#include <imgui.h>
+#include <cstdint>
+#include <vector>
+
+// Input de un tick. steer va de -127 (derecha) a 127 (izquierda).
+struct PlayerInput {
+    enum Buttons : uint8_t {
+        Accelerate = 1 << 0,
+        Brake = 1 << 1,
+        Reset = 1 << 2
+    };
+
+    uint8_t buttons = 0;
+    int8_t steer = 0;
+
+    bool operator==(const PlayerInput& other) const { return buttons == other.buttons && steer == other.steer; }
+    bool operator!=(const PlayerInput& other) const { return !(*this == other); }
+};
+
+// Todo lo que cambia durante la simulacin de un rider, de tamao fijo para copiarlo directo a un snapshot
+struct PlayerState {
+    enum Flags : uint8_t {
+        OnFloor = 1 << 0,
+        Stopped = 1 << 1,
+        Win = 1 << 2,
+        Loose = 1 << 3
+    };
+
+    glm::vec3 position;
+    glm::vec3 velocity;
+    float acceleration;
+    float reaccelerate;
+    float stopTimer;
+    float accTimer;
+    float gameTimer;
+    uint8_t flags;
+};
 
 class Player : public Mona::GameObject {
 public:
-	Player(glm::vec3 initPos, MeshNavigator* meshNav, float timer);
+    // Pasado este z (hacia -z) el rider llega a la meta
+    static constexpr float finishLineZ = -520.698f;
+    // Un rider a menos de esto sobre el suelo se considera apoyado
+    static constexpr float groundThreshold = 0.1f;
+
+	Player(glm::vec3 initPos, MeshNavigator* meshNav, Mona::GameObjectHandle<VoiceManager> voices, float timer);
 	~Player();
 
     virtual void UserStartUp(Mona::World& world) noexcept;
 
     virtual void UserUpdate(Mona::World& world, float timeStep) noexcept;
 
-    void keyPressed(Mona::World& world, float timeStep);
+    // Teclado y gamepad combinados en un input compacto, que es lo que se guarda y se manda por red
+    PlayerInput readInput(Mona::World& world) const;
+
+    // Un paso de la fsica del rider. Solo toca el estado de PlayerState, as que se puede
+    // repetir desde un snapshot y da el mismo resultado.
+    void simulate(const PlayerInput& input, float timeStep);
+
+    void saveState(PlayerState& state) const;
+    void restoreState(const PlayerState& state);
+
+    // Copia la posicin simulada al transform; la simulacin no lo toca para que re-simular sea barato
+    void syncTransform();
 
-    void buttonPressed(Mona::World& world, float timeStep);
+    // Con driven en true UserUpdate no simula: RollbackSession o FrameScheduler llaman simulate
+    void setDriven(bool driven) { mDriven = driven; }
+    // Silencia los sonidos mientras se re-simulan ticks que ya se escucharon
+    void setSilent(bool silent) { mSilent = silent; }
+    // Con deferred en true los sonidos se guardan hasta flushSounds, para poder simular fuera del hilo principal
+    void setDeferredSounds(bool deferred) { mDeferSounds = deferred; }
+    void flushSounds();
 
     void stopPlayer(Mona::World& world);
     void accelleratePlayer(Mona::World& world);
 
-    glm::vec3 getPos();
+    glm::vec3 getPos() const { return mPosition; }
+    glm::vec3 getVelocity() const { return velocity; }
+    bool isOnFloor() const { return onFloor; }
 
     
 private:
+    struct PendingSound {
+        std::shared_ptr<Mona::AudioClip> clip;
+        glm::vec3 position;
+        VoicePriority priority;
+    };
+
+    void playSound(std::shared_ptr<Mona::AudioClip> clip, VoicePriority priority);
+
     Mona::TransformHandle mTransform;
     glm::vec3 mInitPos;
+    glm::vec3 mPosition;
     float game_timer;
     glm::vec3 gravity = glm::vec3(0.0f, -9.8f, 0.0f);
 
@@ -36,7 +106,6 @@ private:
     const float mGlobalSpeed = 5.0f;
     const float slideSpeed = 6.5f;
     const float heightInterpolationSpeed = 1.0f;
-    const float groundThreshold = 0.1f;
 
     const float rotationSpeed = 2.0f;  // Controla la velocidad de giro
     float acceleration = 1.0f;  // Controla qu tan rpido aumenta la velocidad
@@ -54,11 +123,18 @@ private:
     float mAccTimer = 1.0f;
     float mGameTimer = 30.0f;
     MeshNavigator* m_MeshNav;
+    Mona::GameObjectHandle<VoiceManager> mVoices;
+    bool mDriven = false;
+    bool mSilent = false;
+    bool mDeferSounds = false;
+    std::vector<PendingSound> mPendingSounds;
 
     std::shared_ptr<Mona::AudioClip> mAccelerationSound;
     std::shared_ptr<Mona::AudioClip> mSlideSound;
     std::shared_ptr<Mona::AudioClip> mCrashSound;
     std::shared_ptr<Mona::AudioClip> mWinSound;
 
+    TrackedAllocation mTracked{ MemoryTag::GameObjects, sizeof(Player) };
+
     friend class Camera;
 };
\ No newline at end of file
@@ -0,0 +1,140 @@
+#pragma once
+
+#include "player.h"
+#include "course_activation.h"
+#include "loopback_peer.h"
+#include "MonaEngine.hpp"
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+// Estado completo del gameplay al comienzo de un tick. Es de tamaño fijo y trivialmente copiable,
+// así que guardar y restaurar son unas pocas copias de memoria.
+struct GameSnapshot {
+    static constexpr int maxRiders = 2;
+
+    uint32_t tick = 0;
+    CourseActivation::TriggerMask consumedTriggers;
+    PlayerState riders[maxRiders];
+};
+static_assert(std::is_trivially_copyable_v<GameSnapshot>, "GameSnapshot se copia como bloque de memoria");
+
+struct RollbackStats {
+    uint64_t ticks = 0;
+    uint64_t rollbacks = 0;
+    uint64_t resimulatedTicks = 0;
+    uint64_t stalledFrames = 0;     // frames en que no se avanzó esperando inputs remotos
+    int maxRollbackTicks = 0;
+
+    uint64_t saves = 0;
+    uint64_t restores = 0;
+    double saveMicros = 0.0;        // tiempos acumulados
+    double restoreMicros = 0.0;
+    double resimMicros = 0.0;
+};
+
+// Lo que RollbackCore necesita del juego: leer el input local, guardar y restaurar el estado y simular
+// un tick. RollbackSession lo implementa con los Player y la CourseActivation del World.
+class RollbackGame {
+public:
+    virtual ~RollbackGame() = default;
+
+    virtual PlayerInput readLocalInput() = 0;
+    // Llena todo menos snapshot.tick, que pone RollbackCore
+    virtual void saveState(GameSnapshot& snapshot) const = 0;
+    virtual void restoreState(const GameSnapshot& snapshot) = 0;
+    virtual void simulateTick(const PlayerInput& local, const PlayerInput& remote, float timeStep) = 0;
+    // Entre estas dos llamadas se re-simulan ticks que ya se mostraron: sin sonidos ni cambios de dibujo
+    virtual void beginResimulation() = 0;
+    virtual void endResimulation() = 0;
+};
+
+// Carrera de dos riders a tick fijo con rollback: el input remoto que falta se predice repitiendo
+// el último confirmado, y cuando llega uno distinto se restaura el snapshot de ese tick y se
+// re-simula hasta el presente. No depende del motor, así que dos instancias se pueden conectar
+// entre sí (outgoing de una es incoming de la otra) para probar que convergen.
+class RollbackCore {
+public:
+    RollbackCore(RollbackGame* game, LoopbackPeer* outgoing, LoopbackPeer* incoming, float tickRate = 60.0f, int maxRollbackTicks = 12);
+
+    // Recibe inputs, hace rollback si hace falta y simula los ticks que tocan en timeStep
+    void advance(float timeStep);
+
+    uint32_t getTick() const { return mTick; }
+    // Primer tick del que todavía no se tiene el input remoto
+    uint32_t getConfirmedTick() const { return mRemoteConfirmed; }
+    const RollbackStats& getStats() const { return mStats; }
+
+private:
+    static constexpr uint32_t historySize = 64;   // potencia de dos, mayor que maxRollbackTicks e InputPacket::maxInputs
+
+    void saveSnapshot(GameSnapshot& snapshot, uint32_t tick) const;
+    void advanceTick();
+    void simulateTick(uint32_t tick);
+    // Manda los últimos inputs locales anteriores a endTick
+    void sendLocalInputs(uint32_t endTick);
+    // Guarda los inputs remotos que llegaron; retorna el primer tick mal predicho, o mTick si no hubo
+    uint32_t receiveRemoteInputs();
+    void rollback(uint32_t fromTick);
+    PlayerInput remoteInputFor(uint32_t tick) const;
+
+    RollbackGame* mGame;
+    LoopbackPeer* mOutgoing;
+    LoopbackPeer* mIncoming;
+
+    float mTickStep;
+    int mMaxRollbackTicks;
+    float mAccumulator = 0.0f;
+    double mClockMs = 0.0;
+
+    uint32_t mTick = 0;                 // próximo tick a simular
+    uint32_t mRemoteConfirmed = 0;      // todos los ticks anteriores tienen input remoto confirmado
+
+    std::vector<GameSnapshot> mSnapshots;       // índice tick % tamaño, guardado antes de simular el tick
+    std::vector<PlayerInput> mLocalInputs;      // índice tick % historySize
+    std::vector<PlayerInput> mRemoteInputs;
+    std::vector<uint32_t> mRemoteInputTick;     // tick al que corresponde el input confirmado del slot
+    std::vector<PlayerInput> mRemoteUsed;       // input remoto con que se simuló cada tick
+
+    std::vector<InputPacket> mReceived;
+    RollbackStats mStats;
+};
+
+// RollbackCore sobre los riders y los triggers del World. Los riders y la CourseActivation dejan de
+// actualizarse solos: en cada tick se simulan los dos riders, se rehace la ventana de objetos
+// despiertos y se revisan los triggers, así que re-simular un tick da lo mismo que la primera vez.
+class RollbackSession : public Mona::GameObject, private RollbackGame {
+public:
+    RollbackSession(Mona::GameObjectHandle<Player> localRider, Mona::GameObjectHandle<Player> remoteRider, Mona::GameObjectHandle<CourseActivation> activation,
+        LoopbackPeer* peer, float tickRate = 60.0f, int maxRollbackTicks = 12);
+    ~RollbackSession();
+
+    virtual void UserStartUp(Mona::World& world) noexcept;
+
+    virtual void UserUpdate(Mona::World& world, float timeStep) noexcept;
+
+    // Recibe inputs, hace rollback si hace falta y simula los ticks que tocan en este frame
+    void advance(Mona::World& world, float timeStep);
+    // Con scheduled en true UserUpdate no hace nada: FrameScheduler llama advance en la fase de simulación
+    void setScheduled(bool scheduled) { mScheduled = scheduled; }
+
+    uint32_t getTick() const { return mCore.getTick(); }
+    uint32_t getConfirmedTick() const { return mCore.getConfirmedTick(); }
+    const RollbackStats& getStats() const { return mCore.getStats(); }
+
+private:
+    PlayerInput readLocalInput() override;
+    void saveState(GameSnapshot& snapshot) const override;
+    void restoreState(const GameSnapshot& snapshot) override;
+    void simulateTick(const PlayerInput& local, const PlayerInput& remote, float timeStep) override;
+    void beginResimulation() override;
+    void endResimulation() override;
+
+    Mona::GameObjectHandle<Player> mLocalRider;
+    Mona::GameObjectHandle<Player> mRemoteRider;
+    Mona::GameObjectHandle<CourseActivation> mActivation;
+    RollbackCore mCore;
+
+    Mona::World* mWorld = nullptr;      // solo mientras corre advance
+    bool mScheduled = false;
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "memory_tracker.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// Región modificada dentro de un tile, en celdas (rango inclusivo)
+struct DirtyRect {
+    int tileX, tileZ;
+    int minX, minZ, maxX, maxZ;
+};
+
+// Overlay disperso de alturas sobre el terreno: surcos que dejan los riders en la nieve.
+// El mundo se divide en tiles de tileCells x tileCells celdas que solo se crean donde alguien pasó,
+// así que la memoria depende del área pisada y no del tamaño de la pista.
+class SnowDeformation {
+public:
+    static constexpr int tileCells = 32;
+
+    SnowDeformation(float cellSize = 0.25f, float maxDepth = 0.3f);
+
+    // Hunde la nieve con un perfil suave de radio radius centrado en (x, z)
+    void stamp(float x, float z, float radius, float depth);
+
+    // Delta de altura (negativo o cero) en (x, z), interpolado entre celdas; 0 donde no hay tile
+    float getHeightDelta(float x, float z) const;
+
+    // Entrega las regiones modificadas desde la última llamada y las marca como limpias
+    void collectDirtyRects(std::vector<DirtyRect>& out);
+
+    // Deltas del tile en orden fila por fila (z, luego x); nullptr si el tile no existe
+    const float* getTileData(int tileX, int tileZ) const;
+
+    float getCellSize() const { return m_cellSize; }
+    size_t getTileCount() const { return m_tiles.size(); }
+    size_t getMemoryBytes() const { return m_tiles.size() * sizeof(Tile); }
+
+private:
+    struct Tile {
+        float delta[tileCells * tileCells] = {};
+        int dirtyMinX = tileCells, dirtyMinZ = tileCells;
+        int dirtyMaxX = -1, dirtyMaxZ = -1;
+
+        // Los tiles se crean y destruyen sueltos, así que se cuentan aquí en MemoryTag::Effects
+        static void* operator new(size_t size) {
+            void* p = ::operator new(size);
+            MemoryTracker::GetInstance().recordAllocation(MemoryTag::Effects, size);
+            return p;
+        }
+        static void operator delete(void* p, size_t size) {
+            MemoryTracker::GetInstance().recordFree(MemoryTag::Effects, size);
+            ::operator delete(p);
+        }
+    };
+
+    static uint64_t tileKey(int tileX, int tileZ) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(tileX)) << 32) | static_cast<uint32_t>(tileZ);
+    }
+
+    const Tile* findTile(int tileX, int tileZ) const;
+    Tile& getOrCreateTile(int tileX, int tileZ);
+    float nodeDelta(int cellX, int cellZ) const;
+
+    float m_cellSize;
+    float m_invCellSize;
+    float m_maxDepth;
+
+    std::unordered_map<uint64_t, std::unique_ptr<Tile>> m_tiles;
+    std::vector<uint64_t> m_dirtyTiles;
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "memory_tracker.h"
+#include "mesh_navigator.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Sistema de partículas de nieve en CPU. Los datos viven en arreglos separados por atributo
+// (structure of arrays) con capacidad fija: emitir o matar partículas nunca reserva memoria.
+class SnowParticleSystem {
+public:
+    using ParticlePool = std::vector<float, TrackingAllocator<float, MemoryTag::Effects>>;
+    using QuadPool = std::vector<Quad*, TrackingAllocator<Quad*, MemoryTag::Effects>>;
+
+    SnowParticleSystem(size_t capacity);
+
+    // Emite hasta count partículas; las que no caben en el pool se descartan
+    void emit(const glm::vec3& origin, const glm::vec3& baseVelocity, float spread, int count, float lifetime);
+
+    // Integra, choca contra el terreno y elimina las partículas muertas
+    void update(float timeStep, MeshNavigator& meshNav);
+
+    void clear() { m_count = 0; }
+
+    size_t getCount() const { return m_count; }
+    size_t getCapacity() const { return m_capacity; }
+    const float* getPositionX() const { return m_posX.data(); }
+    const float* getPositionY() const { return m_posY.data(); }
+    const float* getPositionZ() const { return m_posZ.data(); }
+    const float* getLife() const { return m_life.data(); }
+    const float* getMaxLife() const { return m_maxLife.data(); }
+
+private:
+    void integrate(size_t begin, size_t end, float timeStep);
+    void collide(size_t begin, size_t end);
+    void removeDead();
+    float random01();
+
+    size_t m_capacity;
+    size_t m_count = 0;
+
+    ParticlePool m_posX, m_posY, m_posZ;
+    ParticlePool m_velX, m_velY, m_velZ;
+    ParticlePool m_life, m_maxLife;
+    ParticlePool m_ground;    // altura del terreno bajo cada partícula, NaN si no hay suelo
+    QuadPool m_quad;          // quad de la última consulta; casi siempre sigue siendo el de la partícula
+
+    uint32_t m_rngState = 0x9E3779B9u;
+
+    const float gravity = -9.8f;
+    const float drag = 1.5f;
+    const float restitution = 0.2f;
+    const float groundFriction = 0.6f;
+
+    // Tamaño de los rangos que se reparten entre hilos; con menos partículas todo corre en el hilo principal
+    static constexpr size_t parallelGrain = 4096;
+};
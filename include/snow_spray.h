@@ -0,0 +1,58 @@
+#pragma once
+
+#include "player.h"
+#include "snow_particles.h"
+#include "MonaEngine.hpp"
+#include "Rendering/DiffuseFlatMaterial.hpp"
+
+// Spray de nieve del rider: emite partículas según el contacto con el suelo y la velocidad del
+// Player, y muestra un subconjunto de ellas con cubos pequeños preasignados. Solo los cubos con
+// partícula tienen mesh, así que los que sobran no entran a la lista de dibujo.
+class SnowSpray : public Mona::GameObject {
+public:
+	SnowSpray(Mona::GameObjectHandle<Player> player, MeshNavigator* meshNav, size_t capacity, int visibleParticles);
+	~SnowSpray();
+
+	virtual void UserStartUp(Mona::World& world) noexcept;
+
+	virtual void UserUpdate(Mona::World& world, float timeStep) noexcept;
+
+	// Emite según el estado actual del rider y avanza las partículas; usa el ThreadPool por dentro,
+	// así que no puede correr dentro de otro parallelFor
+	void updateSpray(Mona::World& world, float timeStep);
+	// Con scheduled en true UserUpdate no hace nada y FrameScheduler llama updateSpray
+	void setScheduled(bool scheduled) { mScheduled = scheduled; }
+
+	const SnowParticleSystem& getParticles() const { return mParticles; }
+
+private:
+	void emitFromPlayer(float timeStep);
+	void updateProxies(Mona::World& world);
+	void setProxyShown(Mona::World& world, size_t index, bool shown);
+
+	Mona::GameObjectHandle<Player> mPlayer;
+	MeshNavigator* m_MeshNav;
+	SnowParticleSystem mParticles;
+
+	struct Proxy {
+		Mona::GameObjectHandle<Mona::GameObject> object;
+		Mona::TransformHandle transform;
+		Mona::ComponentHandle<Mona::StaticMeshComponent> meshComponent;
+		bool shown = false;
+	};
+
+	int mVisibleParticles;
+	std::vector<Proxy> mProxies;
+	std::shared_ptr<Mona::Mesh> mProxyMesh;
+	std::shared_ptr<Mona::Material> mProxyMaterial;
+
+	bool mWasOnFloor = false;
+	float mEmitAccumulator = 0.0f;
+	bool mScheduled = false;
+
+	const float carveMinSpeed = 5.0f;       // bajo esta velocidad no se levanta nieve
+	const float carveRate = 40.0f;          // partículas por segundo por unidad de velocidad
+	const int landingBurst = 400;
+	const float particleLifetime = 1.2f;
+	const float proxySize = 0.08f;
+};
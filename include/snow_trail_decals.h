@@ -0,0 +1,65 @@
+#pragma once
+
+#include "mesh_navigator.h"
+#include "snow_deformation.h"
+#include "MonaEngine.hpp"
+#include "Rendering/DiffuseFlatMaterial.hpp"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Dibuja los surcos que entrega SnowTrails con placas delgadas de nieve pisada sobre el suelo. Cada
+// placa cubre una celda de decalSize; las placas se crean una vez y, cuando se acaban, se reutiliza
+// la más antigua, así que el rastro visible es el último tramo recorrido. Una placa recibe su mesh
+// recién cuando se usa, así que las que nunca se usaron no entran a la lista de dibujo.
+class SnowTrailDecals : public Mona::GameObject {
+public:
+	SnowTrailDecals(MeshNavigator* meshNav, float cellSize, int maxDecals, float decalSize = 0.5f);
+	~SnowTrailDecals();
+
+	virtual void UserStartUp(Mona::World& world) noexcept;
+
+	// Agrega o quita los meshes de las placas que cambiaron desde el frame anterior
+	virtual void UserUpdate(Mona::World& world, float timeStep) noexcept;
+
+	// Para SnowTrails::setUploadCallback: pone o sube las placas de las celdas hundidas del rectángulo.
+	// No recibe el World, así que el mesh de una placa nueva se agrega en el UserUpdate siguiente.
+	void upload(const DirtyRect& rect, const float* tileData);
+
+	int getPlacedCount() const { return static_cast<int>(mDecalOf.size()); }
+
+private:
+	static uint64_t decalKey(int x, int z) {
+		return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(z);
+	}
+
+	void place(int slot, int x, int z);
+	void setShown(int slot, bool shown);
+
+	MeshNavigator* m_MeshNav;
+	float mCellSize;
+	int mMaxDecals;
+	float mDecalSize;
+
+	struct Decal {
+		Mona::GameObjectHandle<Mona::GameObject> object;
+		Mona::TransformHandle transform;
+		Mona::ComponentHandle<Mona::StaticMeshComponent> meshComponent;
+		bool shown = false;         // tiene mesh
+		bool wantShown = false;     // lo que pidió upload
+	};
+
+	std::vector<Decal> mDecals;
+	std::vector<int> mChanged;                      // placas con wantShown distinto de shown
+	std::shared_ptr<Mona::Mesh> mDecalMesh;
+	std::shared_ptr<Mona::Material> mDecalMaterial;
+	std::vector<uint64_t> mSlotKey;                 // celda que ocupa cada placa
+	std::unordered_map<uint64_t, int> mDecalOf;     // celda -> placa
+	int mNextSlot = 0;
+
+	std::vector<uint64_t> mTouched;
+
+	const float minDepth = 0.01f;           // celdas menos hundidas que esto no se dibujan
+	const float decalThickness = 0.01f;
+	const float decalLift = 0.02f;          // sobre el suelo, para que no parpadee con el terreno
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "player.h"
+#include "snow_deformation.h"
+#include "MonaEngine.hpp"
+#include <functional>
+
+// Estampa en SnowDeformation el tramo recorrido entre una llamada y la siguiente y entrega las
+// regiones sucias. No toca el motor, así que se puede usar (y probar) sin World.
+class TrailStamper {
+public:
+	using UploadCallback = std::function<void(const DirtyRect& rect, const float* tileData)>;
+
+	// Profundidad máxima de un surco: el suelo bajo un rider lento o detenido se hunde en un frame hasta
+	// depth, y si eso pasa de Player::groundThreshold el rider queda en el aire y vuelve a "aterrizar"
+	static constexpr float maxDepth = Player::groundThreshold * 0.75f;
+
+	// depth se limita a maxDepth
+	TrailStamper(SnowDeformation* deformation, float radius, float depth);
+
+	// Estampa desde la posición anterior hasta position si el rider está en el suelo
+	void advance(const glm::vec3& position, bool onFloor);
+
+	// Quien dibuje los surcos recibe aquí cada rectángulo sucio con los datos de su tile
+	void setUploadCallback(UploadCallback callback) { mUpload = callback; }
+
+	float getDepth() const { return mDepth; }
+
+private:
+	SnowDeformation* mDeformation;
+	float mRadius;
+	float mDepth;
+
+	glm::vec3 mLastPos = glm::vec3(0.0f);
+	bool mWasOnFloor = false;
+
+	UploadCallback mUpload;
+	std::vector<DirtyRect> mDirtyRects;
+};
+
+// Deja surcos en la nieve por donde pasa el rider y entrega al render solo las regiones modificadas
+class SnowTrails : public Mona::GameObject {
+public:
+	using UploadCallback = TrailStamper::UploadCallback;
+
+	SnowTrails(Mona::GameObjectHandle<Player> player, SnowDeformation* deformation, float radius, float depth);
+	~SnowTrails();
+
+	virtual void UserUpdate(Mona::World& world, float timeStep) noexcept;
+
+	// Estampa el tramo recorrido por el rider y entrega las regiones sucias. Cambia el suelo que lee
+	// la simulación, así que con FrameScheduler corre después de simular y afecta recién al frame siguiente.
+	void updateTrails();
+	// Con scheduled en true UserUpdate no hace nada y FrameScheduler llama updateTrails
+	void setScheduled(bool scheduled) { mScheduled = scheduled; }
+
+	void setUploadCallback(UploadCallback callback) { mStamper.setUploadCallback(callback); }
+
+private:
+	Mona::GameObjectHandle<Player> mPlayer;
+	TrailStamper mStamper;
+	bool mScheduled = false;
+};
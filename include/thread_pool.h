@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Pool de hilos persistente para repartir trabajo de datos (partículas, carga de mallas, etc.).
+// Los hilos se crean una sola vez; parallelFor reparte rangos y el hilo que llama también trabaja.
+class ThreadPool {
+public:
+    static ThreadPool& GetInstance();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ~ThreadPool();
+
+    // Hilos que participan en un parallelFor, contando al que llama
+    int getWorkerCount() const { return static_cast<int>(m_workers.size()) + 1; }
+
+    // Llama fn(begin, end) sobre rangos de a lo más grain elementos hasta cubrir [0, count).
+    // Cada hilo parte con una parte contigua de los rangos y, al terminarla, roba la mitad de lo
+    // que le queda a otro. No es reentrante: fn no debe llamar a parallelFor.
+    void parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& fn);
+
+    // Rangos que un hilo le quitó a otro desde que se creó el pool
+    uint64_t getStealCount() const { return m_steals.load(std::memory_order_relaxed); }
+
+private:
+    // Rangos pendientes de un hilo, [front, back) empaquetados en 64 bits para tomarlos con un solo CAS:
+    // el dueño avanza front y los ladrones retroceden back
+    struct alignas(64) ChunkRange {
+        std::atomic<uint64_t> bounds{ 0 };
+    };
+
+    ThreadPool(unsigned int threadCount);
+
+    void workerLoop(int slot);
+    void runChunks(int slot, const std::function<void(size_t, size_t)>& job);
+    bool popChunk(int slot, uint32_t& chunk);
+    bool stealChunks(int slot);
+
+    std::vector<std::thread> m_workers;
+    std::unique_ptr<ChunkRange[]> m_ranges;     // uno por hilo; el 0 es del que llama
+
+    std::mutex m_callMutex;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+
+    const std::function<void(size_t, size_t)>* m_job = nullptr;
+    size_t m_count = 0;
+    size_t m_grain = 1;
+    int m_active = 0;
+    uint64_t m_generation = 0;
+    bool m_stop = false;
+
+    std::atomic<uint64_t> m_steals = 0;
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "MonaEngine.hpp"
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// Prioridad de una voz: define quién puede robarle la fuente a quién
+enum class VoicePriority {
+	Low = 0,
+	Medium = 1,
+	High = 2,
+	Critical = 3
+};
+
+class VoiceManager : public Mona::GameObject {
+public:
+	VoiceManager(int poolSize, float cullThreshold = 0.01f, float referenceDistance = 10.0f);
+	~VoiceManager();
+
+	virtual void UserStartUp(Mona::World& world) noexcept;
+
+	virtual void UserUpdate(Mona::World& world, float timeStep) noexcept;
+
+	// Libera las voces que terminaron y recalcula la audibilidad con el listener actual
+	void updateVoices(float timeStep);
+	// Con scheduled en true el update lo corre FrameScheduler, después de mover la cámara
+	void setScheduled(bool scheduled) { mScheduled = scheduled; }
+
+	void setListenerTransform(Mona::TransformHandle listener);
+	void setClipLimit(const std::shared_ptr<Mona::AudioClip>& clip, int maxVoices);
+
+	// Reproduce un clip one-shot en una voz del pool. Retorna false si el sonido fue descartado.
+	bool playClip3D(const std::shared_ptr<Mona::AudioClip>& clip, const glm::vec3& position, float volume, VoicePriority priority = VoicePriority::Medium);
+
+private:
+	struct Voice {
+		Mona::GameObjectHandle<Mona::GameObject> object;
+		Mona::TransformHandle transform;
+		Mona::ComponentHandle<Mona::AudioSourceComponent> source;
+		const Mona::AudioClip* clip = nullptr;
+		glm::vec3 position = glm::vec3(0.0f);
+		float volume = 0.0f;
+		float remaining = 0.0f;
+		float audibility = 0.0f;
+		VoicePriority priority = VoicePriority::Low;
+		bool active = false;
+	};
+
+	float computeAudibility(const glm::vec3& position, float volume) const;
+	bool isQuieter(const Voice& voice, VoicePriority priority, float audibility) const;
+	int findVoiceToUse(const Mona::AudioClip* clip, VoicePriority priority, float audibility) const;
+	void stopVoice(Voice& voice);
+
+	int mPoolSize;
+	float mCullThreshold;
+	float mReferenceDistance;
+
+	std::vector<Voice> mVoices;
+	std::unordered_map<const Mona::AudioClip*, int> mClipLimits;
+
+	Mona::TransformHandle mListener;
+	bool mHasListener = false;
+	bool mScheduled = false;
+};
@@ -9,11 +9,53 @@
 #include "player.h"
 #include "camera.h"
 #include "mesh_navigator.h"
+#include "obj_reader.h"
 #include "obstacle.h"
 #include "accelerator.h"
+#include "voice_manager.h"
+#include "snow_spray.h"
+#include "snow_trails.h"
+#include "snow_trail_decals.h"
+#include "course_activation.h"
+#include "memory_tracker.h"
+#include "rollback_session.h"
+#include "frame_scheduler.h"
+#include "thread_pool.h"
+#include "flow_field.h"
 
 
 float GAME_TIMER = 30.0f;
+int VOICE_POOL_SIZE = 16;
+size_t SNOW_PARTICLE_CAPACITY = 32768;
+int SNOW_VISIBLE_PARTICLES = 256;
+int SNOW_TRAIL_DECALS = 1024;
+float COURSE_WAKE_AHEAD = 80.0f;
+float COURSE_KEEP_BEHIND = 10.0f;
+float COURSE_WAKE_RADIUS = 30.0f;
+
+// Carrera contra un rider remoto simulado en local (LoopbackPeer) para probar el rollback
+bool NETPLAY_LOOPBACK = false;
+float LOOPBACK_LATENCY_MS = 80.0f;
+float LOOPBACK_JITTER_MS = 20.0f;
+float LOOPBACK_LOSS_RATE = 0.05f;
+float NETPLAY_TICK_RATE = 60.0f;
+int NETPLAY_MAX_ROLLBACK_TICKS = 12;
+
+// Riders de la CPU que bajan siguiendo el FlowField (no se usan en netplay)
+int CPU_RIDERS = 0;
+float FLOW_FIELD_CELL_SIZE = 1.0f;
+
+// Ítems por rango al repartir una fase entre hilos; con menos ítems que esto la fase corre en el hilo principal
+size_t SCHEDULER_RIDER_GRAIN = 4;
+size_t SCHEDULER_TRIGGER_GRAIN = 32;
+
+// Presupuestos de memoria por subsistema, en MB
+size_t NAVIGATOR_BUDGET_MB = 16;
+size_t TEXTURES_BUDGET_MB = 96;
+size_t MESHES_BUDGET_MB = 32;
+size_t AUDIO_BUDGET_MB = 64;
+size_t GAME_OBJECTS_BUDGET_MB = 1;
+size_t EFFECTS_BUDGET_MB = 16;
 
 void AddDirectionalLight(Mona::World& world, const glm::vec3& axis, float angle, float lightIntensity)
 {
@@ -35,16 +77,30 @@ public:
 		auto& meshManager = Mona::MeshManager::GetInstance();
 		auto& config = Mona::Config::GetInstance();
 		auto& textureManager = Mona::TextureManager::GetInstance();
-		
+		auto& memory = MemoryTracker::GetInstance();
+		memory.setBudget(MemoryTag::Navigator, NAVIGATOR_BUDGET_MB << 20);
+		memory.setBudget(MemoryTag::Textures, TEXTURES_BUDGET_MB << 20);
+		memory.setBudget(MemoryTag::Meshes, MESHES_BUDGET_MB << 20);
+		memory.setBudget(MemoryTag::Audio, AUDIO_BUDGET_MB << 20);
+		memory.setBudget(MemoryTag::GameObjects, GAME_OBJECTS_BUDGET_MB << 20);
+		memory.setBudget(MemoryTag::Effects, EFFECTS_BUDGET_MB << 20);
+		world.GetEventManager().Subscribe(m_debugGUISubcription, this, &Snowboarding::OnDebugGUIEvent);
+
+		// Lo que cargan los managers del motor se estima desde el archivo
+		auto loadTexture = [&](const std::string& asset) {
+			std::filesystem::path path = config.getPathOfApplicationAsset(asset);
+			memory.trackTextureFile(path);
+			return textureManager.LoadTexture(path);
+		};
 
 		// Setting Map
 		world.SetBackgroundColor(0.1f, 0.1f, 1.0f, 1.0f);
 		std::shared_ptr<Mona::PBRTexturedMaterial> terr_material = std::static_pointer_cast<Mona::PBRTexturedMaterial>(world.CreateMaterial(Mona::MaterialType::PBRTextured));
-		std::shared_ptr<Mona::Texture> albedo = textureManager.LoadTexture(config.getPathOfApplicationAsset("albedo_scnd.png"));
-		std::shared_ptr<Mona::Texture> normalMap = textureManager.LoadTexture(config.getPathOfApplicationAsset("normal_scnd.png"));
-		std::shared_ptr<Mona::Texture> metallic = textureManager.LoadTexture(config.getPathOfApplicationAsset("metallic_scnd.png"));
-		std::shared_ptr<Mona::Texture> roughness = textureManager.LoadTexture(config.getPathOfApplicationAsset("rough_scnd.png"));
-		std::shared_ptr<Mona::Texture> ambientOcclusion = textureManager.LoadTexture(config.getPathOfApplicationAsset("AO_scnd.png"));
+		std::shared_ptr<Mona::Texture> albedo = loadTexture("albedo_scnd.png");
+		std::shared_ptr<Mona::Texture> normalMap = loadTexture("normal_scnd.png");
+		std::shared_ptr<Mona::Texture> metallic = loadTexture("metallic_scnd.png");
+		std::shared_ptr<Mona::Texture> roughness = loadTexture("rough_scnd.png");
+		std::shared_ptr<Mona::Texture> ambientOcclusion = loadTexture("AO_scnd.png");
 		terr_material->SetAlbedoTexture(albedo);
 		terr_material->SetNormalMapTexture(normalMap);
 		terr_material->SetMetallicTexture(normalMap);
@@ -56,8 +112,14 @@ public:
 		mapTransform->Scale(glm::vec3(terr_scale));
 		std::filesystem::path terrain_p = config.getPathOfApplicationAsset("scnd_snow_terrain_T.obj");
 		world.AddComponent<Mona::StaticMeshComponent>(map, meshManager.LoadMesh(terrain_p, true), terr_material);
+		memory.trackMeshFile(terrain_p, estimateObjMeshBytes(terrain_p.string()));
 
 		MeshNavigator* meshNav = new MeshNavigator(terrain_p.string(), terr_scale);
+		mMeshNav = meshNav;
+		mSnowDeformation = std::make_unique<SnowDeformation>();
+		// En netplay los surcos quedan solo visuales: dependen de por dónde pasó el rider en frames
+		// ya simulados, así que re-simular sobre ellos no daría lo mismo que la primera vez
+		if (!NETPLAY_LOOPBACK) meshNav->setOverlay(mSnowDeformation.get());
 
 		// setting light and gravity
 		world.SetGravity(glm::vec3(0.0f, 0.0f, 0.0f));
@@ -66,12 +128,20 @@ public:
 		float sunIntensity = 4.0f;
 		AddDirectionalLight(world, sunAxis, sunAngle, sunIntensity);
 		world.SetAmbientLight(glm::vec3(0.9f));
-		auto player = world.CreateGameObject<Player>(glm::vec3(5.14424, 18.117, -5.95871), meshNav, GAME_TIMER);
+		auto voices = world.CreateGameObject<VoiceManager>(VOICE_POOL_SIZE);
+		auto player = world.CreateGameObject<Player>(glm::vec3(5.14424, 18.117, -5.95871), meshNav, voices, GAME_TIMER);
 		auto camera = world.CreateGameObject<Camera>(player, 15.0f, 0.0f, 0.0f);
+		voices->setListenerTransform(camera->getTransform());
+		auto snowSpray = world.CreateGameObject<SnowSpray>(player, meshNav, SNOW_PARTICLE_CAPACITY, SNOW_VISIBLE_PARTICLES);
+		auto snowTrails = world.CreateGameObject<SnowTrails>(player, mSnowDeformation.get(), 0.6f, 0.07f);
+		auto trailDecals = world.CreateGameObject<SnowTrailDecals>(meshNav, mSnowDeformation->getCellSize(), SNOW_TRAIL_DECALS);
+		snowTrails->setUploadCallback([trailDecals](const DirtyRect& rect, const float* tileData) { trailDecals->upload(rect, tileData); });
 
 		// ambient music
 		world.SetAudioListenerTransform(camera->getTransform());
-		auto audioClipPtr = audioClipManager.LoadAudioClip(config.getPathOfApplicationAsset("Sounds/APOGG/MegaBotBay.wav"));
+		std::filesystem::path music_p = config.getPathOfApplicationAsset("Sounds/APOGG/MegaBotBay.wav");
+		memory.trackAudioFile(music_p);
+		auto audioClipPtr = audioClipManager.LoadAudioClip(music_p);
 		auto audioSource = world.AddComponent<Mona::AudioSourceComponent>(camera, audioClipPtr);
 		audioSource->SetIsLooping(true);
 		audioSource->SetVolume(0.15f);
@@ -84,30 +154,193 @@ public:
 		Mona::TransformHandle transform = world.AddComponent<Mona::TransformComponent>(cube, glm::vec3(0.0f, 0.0f, -5.0f), glm::fquat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(1.0f));
 		world.AddComponent<Mona::StaticMeshComponent>(cube, meshManager.LoadMesh(Mona::Mesh::PrimitiveType::Cube), wallMaterial);
 
+		// Los objetos de la pista solo se actualizan y dibujan cerca del rider
+		auto activation = world.CreateGameObject<CourseActivation>(COURSE_WAKE_AHEAD, COURSE_KEEP_BEHIND, COURSE_WAKE_RADIUS);
+		activation->addRider(player);
+
 		float obstacleScale = 2.0f;
-		auto snowMan1 = world.CreateGameObject<Obstacle>(terr_scale * glm::vec3(-0.4318f, -0.2439f, -2.3424f), player, obstacleScale);
-		auto snowMan2 = world.CreateGameObject<Obstacle>(terr_scale * glm::vec3(0.1363f, -0.459f, -4.0663f), player, obstacleScale);
-		auto snowMan3 = world.CreateGameObject<Obstacle>(terr_scale * glm::vec3(-0.02272f, -0.4694f, -6.5291f), player, obstacleScale);
-		auto snowMan4 = world.CreateGameObject<Obstacle>(terr_scale * glm::vec3(0.409f, -0.7656f, -6.5291f), player, obstacleScale);
-		auto snowMan5 = world.CreateGameObject<Obstacle>(terr_scale * glm::vec3(-0.72727f, -0.8576f, -7.2679f), player, obstacleScale);
-		auto snowMan6 = world.CreateGameObject<Obstacle>(terr_scale * glm::vec3(-0.7045f, -1.1168f, -9.3615f), player, obstacleScale);
-		auto snowMan7 = world.CreateGameObject<Obstacle>(terr_scale * glm::vec3(0.6818f, -1.14718f, -9.6078f), player, obstacleScale);
-		auto snowMan8 = world.CreateGameObject<Obstacle>(terr_scale * glm::vec3(0.01f, -1.22386f, -10.2235f), player, obstacleScale*4.0f);
+		auto snowMan1 = world.CreateGameObject<Obstacle>(terr_scale * glm::vec3(-0.4318f, -0.2439f, -2.3424f), activation, obstacleScale);
+		auto snowMan2 = world.CreateGameObject<Obstacle>(terr_scale * glm::vec3(0.1363f, -0.459f, -4.0663f), activation, obstacleScale);
+		auto snowMan3 = world.CreateGameObject<Obstacle>(terr_scale * glm::vec3(-0.02272f, -0.4694f, -6.5291f), activation, obstacleScale);
+		auto snowMan4 = world.CreateGameObject<Obstacle>(terr_scale * glm::vec3(0.409f, -0.7656f, -6.5291f), activation, obstacleScale);
+		auto snowMan5 = world.CreateGameObject<Obstacle>(terr_scale * glm::vec3(-0.72727f, -0.8576f, -7.2679f), activation, obstacleScale);
+		auto snowMan6 = world.CreateGameObject<Obstacle>(terr_scale * glm::vec3(-0.7045f, -1.1168f, -9.3615f), activation, obstacleScale);
+		auto snowMan7 = world.CreateGameObject<Obstacle>(terr_scale * glm::vec3(0.6818f, -1.14718f, -9.6078f), activation, obstacleScale);
+		auto snowMan8 = world.CreateGameObject<Obstacle>(terr_scale * glm::vec3(0.01f, -1.22386f, -10.2235f), activation, obstacleScale*4.0f);
 
 		float acceleratorScale = 4.0f;
-		auto arc1 = world.CreateGameObject<Accelerator>(terr_scale * glm::vec3(-0.28f, -0.4282f, -3.82f), player, acceleratorScale*2.0f);
-		auto arc2 = world.CreateGameObject<Accelerator>(terr_scale * glm::vec3(-0.568, -0.704f, -6.0365f), player, acceleratorScale*2.0f);
-		auto arc3 = world.CreateGameObject<Accelerator>(terr_scale * glm::vec3(0.568, -0.704f, -6.0365f), player, acceleratorScale*2.0f);
-		auto goalLine = world.CreateGameObject<Accelerator>(terr_scale * glm::vec3(0.01f, -1.25453f, -10.4698f), player, acceleratorScale*5.0f);
+		auto arc1 = world.CreateGameObject<Accelerator>(terr_scale * glm::vec3(-0.28f, -0.4282f, -3.82f), activation, acceleratorScale*2.0f);
+		auto arc2 = world.CreateGameObject<Accelerator>(terr_scale * glm::vec3(-0.568, -0.704f, -6.0365f), activation, acceleratorScale*2.0f);
+		auto arc3 = world.CreateGameObject<Accelerator>(terr_scale * glm::vec3(0.568, -0.704f, -6.0365f), activation, acceleratorScale*2.0f);
+		auto goalLine = world.CreateGameObject<Accelerator>(terr_scale * glm::vec3(0.01f, -1.25453f, -10.4698f), activation, acceleratorScale*5.0f);
+
+		if (CPU_RIDERS > 0 && !NETPLAY_LOOPBACK) {
+			for (int i = 0; i < CPU_RIDERS; i++) {
+				// Se reparten a ambos lados de la partida del jugador
+				float offset = 2.0f * (i / 2 + 1) * (i % 2 == 0 ? 1.0f : -1.0f);
+				auto cpuRider = world.CreateGameObject<Player>(glm::vec3(5.14424 + offset, 18.117, -5.95871), meshNav, voices, GAME_TIMER);
+				activation->addRider(cpuRider);
+			}
+			mFlowField = std::make_unique<FlowField>(FLOW_FIELD_CELL_SIZE);
+			for (int i = 0; i < activation->getObjectCount(); i++) {
+				mFlowField->addObject(activation->getObject(i));
+			}
+			mFlowField->build(*meshNav);
+		}
+
+		if (NETPLAY_LOOPBACK) {
+			// El rider remoto repite los inputs locales, que le llegan con la latencia y pérdida del peer
+			auto remotePlayer = world.CreateGameObject<Player>(glm::vec3(8.14424, 18.117, -5.95871), meshNav, voices, GAME_TIMER);
+			activation->addRider(remotePlayer);
+			mPeer = std::make_unique<LoopbackPeer>(LOOPBACK_LATENCY_MS, LOOPBACK_JITTER_MS, LOOPBACK_LOSS_RATE);
+			mSession = world.CreateGameObject<RollbackSession>(player, remotePlayer, activation, mPeer.get(), NETPLAY_TICK_RATE, NETPLAY_MAX_ROLLBACK_TICKS);
+		}
+
+		// El gameplay del frame corre por fases: así los triggers siempre ven la posición de este frame
+		// y la cámara y el audio siempre van después de mover a los riders, sin importar el orden de creación
+		mScheduler = world.CreateGameObject<FrameScheduler>();
+		std::vector<Mona::GameObjectHandle<Player>> riders = activation->getRiders();
+		for (auto& rider : riders) rider->setDeferredSounds(true);
+		camera->setScheduled(true);
+		voices->setScheduled(true);
+		snowSpray->setScheduled(true);
+		snowTrails->setScheduled(true);
 
+		if (NETPLAY_LOOPBACK) {
+			// El rollback avanza por ticks y en cada uno lee input, simula, rehace la ventana de despiertos y
+			// revisa triggers, así que va entero en una fase y la CourseActivation no corre por su cuenta
+			mSession->setScheduled(true);
+			activation->setScheduled(true);
+			mScheduler->addTask(FramePhase::Simulation, [session = mSession](Mona::World& world, float timeStep) {
+				session->advance(world, timeStep);
+			});
+		}
+		else {
+			for (auto& rider : riders) rider->setDriven(true);
+			activation->setScheduled(true);
+			mRiderInputs.resize(riders.size());
+
+			// El primer rider es el jugador; los demás son de la CPU y doblan con una consulta al campo
+			mScheduler->addTask(FramePhase::Input, [this, riders](Mona::World& world, float timeStep) {
+				mRiderInputs[0] = riders[0]->readInput(world);
+			});
+			if (mFlowField != nullptr) {
+				mScheduler->addParallelTask(FramePhase::Input, [riders]() { return riders.size() - 1; },
+					[this, riders](size_t i, float timeStep) { mRiderInputs[i + 1] = mFlowField->steer(riders[i + 1]->getPos(), riders[i + 1]->getVelocity()); }, SCHEDULER_RIDER_GRAIN);
+			}
+			mScheduler->addParallelTask(FramePhase::Simulation, [riders]() { return riders.size(); },
+				[this, riders](size_t i, float timeStep) { riders[i]->simulate(mRiderInputs[i], timeStep); }, SCHEDULER_RIDER_GRAIN);
+
+			mScheduler->addTask(FramePhase::Triggers, [activation](Mona::World& world, float timeStep) { activation->updateWindow(world); });
+			mScheduler->addParallelTask(FramePhase::Triggers, [activation]() { return activation->beginContacts(); },
+				[activation](size_t i, float timeStep) { activation->findContacts(i, i + 1); }, SCHEDULER_TRIGGER_GRAIN);
+			mScheduler->addTask(FramePhase::Events, [activation](Mona::World& world, float timeStep) { activation->applyContacts(world); });
+			if (mFlowField != nullptr) {
+				// Un obstáculo o gate consumido deja de desviar a la CPU desde el frame siguiente
+				mScheduler->addTask(FramePhase::Events, [this](Mona::World& world, float timeStep) { mFlowField->refresh(); });
+			}
+		}
+
+		// Los surcos cambian el suelo que lee la simulación: se estampan después de ella y cuentan desde el frame siguiente
+		mScheduler->addTask(FramePhase::Events, [snowTrails](Mona::World& world, float timeStep) { snowTrails->updateTrails(); });
+
+		mScheduler->addTask(FramePhase::Presentation, [riders, camera, voices, snowSpray](Mona::World& world, float timeStep) {
+			for (auto& rider : riders) rider->syncTransform();
+			camera->updateView(world);
+			// El listener ya está en su lugar, así que los sonidos del frame se priorizan con la audibilidad correcta
+			voices->updateVoices(timeStep);
+			for (auto& rider : riders) rider->flushSounds();
+			snowSpray->updateSpray(world, timeStep);
+		});
 	}
 
 
 	virtual void UserShutDown(Mona::World& world) noexcept override {
+		world.GetEventManager().Unsubscribe(m_debugGUISubcription);
+#if defined(SNOWBOARDING_NAV_VALIDATE)
+		NavValidationReport report = mMeshNav->getBackend().getReport();
+		std::cout << "[nav] " << report.queries << " consultas, " << report.presenceMismatches << " de presencia, "
+			<< report.heightMismatches << " de altura (máx " << report.maxHeightError << "), "
+			<< report.normalMismatches << " de normal (máx " << report.maxNormalErrorDegrees << " grados), "
+			<< report.quadMismatches << " de quad en " << report.quadQueries << std::endl;
+#endif
 	}
 	virtual void UserUpdate(Mona::World& world, float timeStep) noexcept override {
+		MemoryTracker::GetInstance().checkBudgets();
+	}
+
+	void OnDebugGUIEvent(const Mona::DebugGUIEvent& event) {
+		auto& memory = MemoryTracker::GetInstance();
+		ImGui::Begin("Memory");
+		for (int i = 0; i < static_cast<int>(MemoryTag::Count); i++) {
+			MemoryTag tag = static_cast<MemoryTag>(i);
+			MemoryStats stats = memory.getStats(tag);
+			ImGui::Text("%s: %.2f MB (peak %.2f MB, budget %.0f MB)%s", memoryTagName(tag),
+				stats.liveBytes / 1048576.0, stats.peakBytes / 1048576.0, stats.budgetBytes / 1048576.0,
+				memoryTagIsEstimate(tag) ? " (estimated)" : "");
+			ImGui::Text("    %llu allocs, %llu frees", static_cast<unsigned long long>(stats.allocations), static_cast<unsigned long long>(stats.frees));
+		}
+		ImGui::Text("estimated: sized from the asset files; engine-side buffers such as the Assimp import are not measured");
+		if (ImGui::Button("Dump")) {
+			if (!memory.dumpToFile("memory_report.txt")) {
+				std::cout << "Failed to write memory_report.txt" << std::endl;
+			}
+		}
+		ImGui::End();
+
+		if (NETPLAY_LOOPBACK) {
+			const RollbackStats& stats = mSession->getStats();
+			ImGui::Begin("Netplay");
+			ImGui::Text("tick %u, confirmed %u", mSession->getTick(), mSession->getConfirmedTick());
+			ImGui::Text("packets: %llu sent, %llu dropped", static_cast<unsigned long long>(mPeer->getSentCount()), static_cast<unsigned long long>(mPeer->getDroppedCount()));
+			ImGui::Text("rollbacks: %llu (%llu ticks, max %d), stalled frames: %llu", static_cast<unsigned long long>(stats.rollbacks),
+				static_cast<unsigned long long>(stats.resimulatedTicks), stats.maxRollbackTicks, static_cast<unsigned long long>(stats.stalledFrames));
+			ImGui::Text("save %.3f us, restore %.3f us, resim %.3f us/tick",
+				stats.saves > 0 ? stats.saveMicros / stats.saves : 0.0,
+				stats.restores > 0 ? stats.restoreMicros / stats.restores : 0.0,
+				stats.resimulatedTicks > 0 ? stats.resimMicros / stats.resimulatedTicks : 0.0);
+			ImGui::End();
+		}
+
+		ImGui::Begin("Scheduler");
+		ImGui::Text("frame %.3f ms, %d threads, %llu steals", mScheduler->getFrameMillis(), ThreadPool::GetInstance().getWorkerCount(),
+			static_cast<unsigned long long>(mScheduler->getSteals()));
+		for (int i = 0; i < static_cast<int>(FramePhase::Count); i++) {
+			FramePhase phase = static_cast<FramePhase>(i);
+			const PhaseStats& stats = mScheduler->getStats(phase);
+			ImGui::Text("%s: %.3f ms, %zu items, %d fan-outs", framePhaseName(phase), stats.millis, stats.items, stats.fanOuts);
+		}
+		if (mFlowField != nullptr) {
+			ImGui::Text("flow field %dx%d: built in %.2f ms, last repair %zu cells", mFlowField->getWidth(), mFlowField->getDepth(),
+				mFlowField->getBuildMillis(), mFlowField->getLastRepairCells());
+		}
+		ImGui::End();
+
+#if defined(SNOWBOARDING_NAV_VALIDATE)
+		NavValidationReport report = mMeshNav->getBackend().getReport();
+		ImGui::Begin("Navigator");
+		ImGui::Text("%s vs %s", SelectedNavBackend::name, ReferenceNavBackend::name);
+		ImGui::Text("samples: %llu, presence mismatches: %llu", static_cast<unsigned long long>(report.queries),
+			static_cast<unsigned long long>(report.presenceMismatches));
+		ImGui::Text("height mismatches: %llu (max %.4f)", static_cast<unsigned long long>(report.heightMismatches), report.maxHeightError);
+		ImGui::Text("normal mismatches: %llu (max %.2f deg)", static_cast<unsigned long long>(report.normalMismatches), report.maxNormalErrorDegrees);
+		ImGui::Text("quad mismatches: %llu of %llu", static_cast<unsigned long long>(report.quadMismatches),
+			static_cast<unsigned long long>(report.quadQueries));
+		ImGui::End();
+#endif
 	}
 
+private:
+	Mona::SubscriptionHandle m_debugGUISubcription;
+	MeshNavigator* mMeshNav = nullptr;
+	// La app vive más que el Engine (y su World), así que los GameObjects que la usan se destruyen antes
+	std::unique_ptr<SnowDeformation> mSnowDeformation;
+	std::unique_ptr<LoopbackPeer> mPeer;
+	Mona::GameObjectHandle<RollbackSession> mSession;
+	Mona::GameObjectHandle<FrameScheduler> mScheduler;
+	std::vector<PlayerInput> mRiderInputs;
+	std::unique_ptr<FlowField> mFlowField;
+
 };
 int main() {
 	Snowboarding app;
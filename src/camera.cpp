@@ -27,6 +27,10 @@ void Camera::UserStartUp(Mona::World& world) noexcept {
 
 
 void Camera::UserUpdate(Mona::World& world, float timeStep) noexcept {
+    if (!mScheduled) updateView(world);
+}
+
+void Camera::updateView(Mona::World& world) {
     mouseMoved(world);
     mouseWheelScrolled(world);
     controllerButtonsPressed(world);
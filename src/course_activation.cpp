@@ -0,0 +1,188 @@
+#include "course_activation.h"
+#include <algorithm>
+#include <iostream>
+
+CourseActivation::CourseActivation(float wakeAhead, float keepBehind, float wakeRadius, glm::vec3 courseDirection) :
+	mWakeAhead(wakeAhead), mKeepBehind(keepBehind), mWakeRadius(wakeRadius), mCourseDirection(glm::normalize(courseDirection)) {}
+
+CourseActivation::~CourseActivation() = default;
+
+void CourseActivation::UserStartUp(Mona::World& world) noexcept {}
+
+void CourseActivation::addRider(Mona::GameObjectHandle<Player> rider) {
+	mRiders.push_back(rider);
+}
+
+void CourseActivation::registerObject(CourseObject* object) {
+	// Los objetos parten despiertos y dibujados; el primer update duerme los que estén lejos
+	mEntries.push_back({ object, progressOf(object->getCoursePosition()), State::Awake, 0, false });
+	if (mEntries.size() == maxSnapshotTriggers + 1) {
+		std::cout << "CourseActivation: more than " << maxSnapshotTriggers << " course objects, the rest are left out of rollback snapshots" << std::endl;
+	}
+	mSorted = false;
+}
+
+void CourseActivation::sortEntries() {
+	std::sort(mEntries.begin(), mEntries.end(), [](const Entry& a, const Entry& b) { return a.progress < b.progress; });
+	// Los índices cambiaron, así que la lista de despiertos se rehace (solo pasa al registrar objetos)
+	mAwake.clear();
+	mConsumedMask.reset();
+	for (int i = 0; i < mEntries.size(); i++) {
+		if (mEntries[i].state == State::Awake) mAwake.push_back(i);
+		if (mEntries[i].state == State::Retired && i < maxSnapshotTriggers) mConsumedMask.set(i);
+	}
+	mSorted = true;
+}
+
+void CourseActivation::collectWindow() {
+	mNextAwake.clear();
+	float searchBehind = std::max(mKeepBehind, mWakeRadius);
+	float searchAhead = std::max(mWakeAhead, mWakeRadius);
+
+	for (auto& rider : mRiders) {
+		glm::vec3 riderPos = rider->getPos();
+		float p = progressOf(riderPos);
+
+		// Lo que está a menos de wakeRadius también está a menos de wakeRadius en avance,
+		// así que basta revisar este rango de la lista ordenada
+		auto first = std::lower_bound(mEntries.begin(), mEntries.end(), p - searchBehind,
+			[](const Entry& entry, float progress) { return entry.progress < progress; });
+		for (auto it = first; it != mEntries.end() && it->progress <= p + searchAhead; ++it) {
+			if (it->state == State::Retired || it->wantedFrame == mFrame) continue;
+
+			bool inWindow = (p - mKeepBehind <= it->progress && it->progress <= p + mWakeAhead) ||
+				glm::length(it->object->getCoursePosition() - riderPos) < mWakeRadius;
+			if (!inWindow) continue;
+
+			it->wantedFrame = mFrame;
+			mNextAwake.push_back(static_cast<int>(it - mEntries.begin()));
+		}
+	}
+}
+
+void CourseActivation::UserUpdate(Mona::World& world, float timeStep) noexcept {
+	if (mScheduled) return;
+	updateWindow(world);
+	updateTriggers(world);
+}
+
+void CourseActivation::updateWindow(Mona::World& world) {
+	if (!mSorted) sortEntries();
+	mFrame++;
+
+	collectWindow();
+
+	// Se duermen los que estaban despiertos y ya no están en la ventana...
+	for (int index : mAwake) {
+		Entry& entry = mEntries[index];
+		if (entry.state == State::Awake && entry.wantedFrame != mFrame) {
+			entry.state = State::Asleep;
+			setRendered(world, entry, false);
+		}
+	}
+	// ...y se despiertan los que acaban de entrar
+	for (int index : mNextAwake) {
+		Entry& entry = mEntries[index];
+		if (entry.state == State::Asleep) {
+			entry.state = State::Awake;
+			setRendered(world, entry, true);
+		}
+	}
+	std::swap(mAwake, mNextAwake);
+}
+
+size_t CourseActivation::beginContacts() {
+	if (!mSorted) sortEntries();
+
+	mRiderPositions.resize(mRiders.size());
+	for (int i = 0; i < mRiders.size(); i++) {
+		mRiderPositions[i] = mRiders[i]->getPos();
+	}
+	mContacts.assign(mAwake.size(), -1);
+	return mAwake.size();
+}
+
+void CourseActivation::findContacts(size_t begin, size_t end) {
+	for (size_t i = begin; i < end; i++) {
+		const Entry& entry = mEntries[mAwake[i]];
+		// Con varios ticks por frame puede haber retirados que siguen en la lista hasta la próxima ventana
+		if (entry.state != State::Awake) continue;
+		mContacts[i] = entry.object->findContact(mRiderPositions);
+	}
+}
+
+void CourseActivation::applyContacts(Mona::World& world) {
+	// Todos los objetos revisaron las mismas posiciones, así que aplicar en orden da lo mismo que
+	// revisar y aplicar uno por uno: los efectos no mueven a los riders
+	for (size_t i = 0; i < mContacts.size(); i++) {
+		int index = mAwake[i];
+		Entry& entry = mEntries[index];
+		if (entry.state != State::Awake) continue;
+		if (mContacts[i] >= 0) entry.object->applyContact(world, mRiders[mContacts[i]]);
+		if (entry.object->isConsumed()) retire(world, index);
+	}
+}
+
+void CourseActivation::updateTriggers(Mona::World& world) {
+	findContacts(0, beginContacts());
+	applyContacts(world);
+}
+
+void CourseActivation::retire(Mona::World& world, int index) {
+	// Trigger de un solo uso: no vuelve a actualizarse ni a dibujarse
+	Entry& entry = mEntries[index];
+	entry.state = State::Retired;
+	setRendered(world, entry, false);
+	mRetiredCount++;
+	if (index < maxSnapshotTriggers) mConsumedMask.set(index);
+}
+
+void CourseActivation::setRendered(Mona::World& world, Entry& entry, bool rendered) {
+	// Un pendiente se resuelve en applyVisibility con el estado que tenga entonces
+	if (entry.visibilityPending) return;
+	if (mVisibilityDeferred) {
+		entry.visibilityPending = true;
+		mPendingVisibility.push_back(static_cast<int>(&entry - mEntries.data()));
+		return;
+	}
+	entry.object->setRendered(world, rendered);
+}
+
+void CourseActivation::restoreConsumed(const TriggerMask& consumed) {
+	if (!mSorted) sortEntries();
+
+	TriggerMask changed = consumed ^ mConsumedMask;
+	if (changed.none()) return;
+
+	int count = std::min(static_cast<int>(mEntries.size()), maxSnapshotTriggers);
+	for (int i = 0; i < count; i++) {
+		if (!changed[i]) continue;
+		Entry& entry = mEntries[i];
+		entry.object->setConsumed(consumed[i]);
+		if (!entry.visibilityPending) {
+			entry.visibilityPending = true;
+			mPendingVisibility.push_back(i);
+		}
+		if (consumed[i]) {
+			entry.state = State::Retired;
+			mRetiredCount++;
+			mConsumedMask.set(i);
+			continue;
+		}
+		// Vuelve despierto para que la re-simulación lo revise; la próxima ventana lo duerme si está lejos
+		entry.state = State::Awake;
+		mRetiredCount--;
+		mConsumedMask.reset(i);
+		if (std::find(mAwake.begin(), mAwake.end(), i) == mAwake.end()) mAwake.push_back(i);
+	}
+}
+
+void CourseActivation::applyVisibility(Mona::World& world) {
+	// Un trigger que el rollback devolvió y la re-simulación volvió a consumir no llega a dibujarse
+	for (int index : mPendingVisibility) {
+		Entry& entry = mEntries[index];
+		entry.visibilityPending = false;
+		entry.object->setRendered(world, entry.state == State::Awake);
+	}
+	mPendingVisibility.clear();
+}
@@ -0,0 +1,26 @@
+#include "course_object.h"
+
+void CourseObject::addMeshPart(Mona::World& world, const glm::vec3& position, const glm::vec3& scale, std::shared_ptr<Mona::Mesh> mesh, std::shared_ptr<Mona::Material> material) {
+	MeshPart part;
+	part.object = world.CreateGameObject<Mona::GameObject>();
+	world.AddComponent<Mona::TransformComponent>(part.object, position, glm::fquat(1.0f, 0.0f, 0.0f, 0.0f), scale);
+	part.mesh = mesh;
+	part.material = material;
+	if (mRendered) part.meshComponent = world.AddComponent<Mona::StaticMeshComponent>(part.object, mesh, material);
+	mParts.push_back(part);
+}
+
+void CourseObject::setRendered(Mona::World& world, bool rendered) {
+	if (rendered == mRendered) return;
+	mRendered = rendered;
+
+	// El transform se queda; solo el mesh entra o sale de la lista de dibujo
+	for (auto& part : mParts) {
+		if (rendered) {
+			part.meshComponent = world.AddComponent<Mona::StaticMeshComponent>(part.object, part.mesh, part.material);
+		}
+		else {
+			world.RemoveComponent(part.meshComponent);
+		}
+	}
+}
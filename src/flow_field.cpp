@@ -0,0 +1,327 @@
+#include "flow_field.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+
+static const float wallSlopeDegrees = 50.0f;    // más empinado que esto es la pared de la pista
+static const float wallPenalty = 10.0f;
+static const float uphillCost = 4.0f;           // por metro de subida
+static const float minFactor = 0.2f;
+static const float slideBlend = 0.35f;          // peso del deslizamiento frente a la bajada del costo
+static const float fullSteerAngle = 0.35f;      // error en radianes con que se gira a fondo
+static const float infiniteCost = std::numeric_limits<float>::infinity();
+
+static const int neighborCount = 8;
+static const int neighborX[neighborCount] = { 1, -1, 0, 0, 1, 1, -1, -1 };
+static const int neighborZ[neighborCount] = { 0, 0, 1, -1, 1, -1, 1, -1 };
+static const float neighborDistance[neighborCount] = { 1.0f, 1.0f, 1.0f, 1.0f, 1.41421356f, 1.41421356f, 1.41421356f, 1.41421356f };
+
+FlowField::FlowField(float cellSize, float finishZ) : m_cellSize(cellSize), m_finishZ(finishZ) {}
+
+void FlowField::addObject(CourseObject* object) {
+	m_objects.push_back({ object, object->isConsumed() });
+}
+
+void FlowField::build(MeshNavigator& navigator) {
+	auto start = std::chrono::steady_clock::now();
+	if (navigator.quads.empty()) {
+		std::cout << "FlowField: the navigator has no quads, there is nothing to build" << std::endl;
+		return;
+	}
+
+	float minX = infiniteCost, minZ = infiniteCost;
+	float maxX = -infiniteCost, maxZ = -infiniteCost;
+	for (const Quad* quad : navigator.quads) {
+		for (const glm::vec3& v : { quad->v0, quad->v1, quad->v2, quad->v3 }) {
+			minX = std::min(minX, v.x);
+			maxX = std::max(maxX, v.x);
+			minZ = std::min(minZ, v.z);
+			maxZ = std::max(maxZ, v.z);
+		}
+	}
+	m_minX = minX;
+	m_minZ = minZ;
+	m_width = std::max(1, static_cast<int>(std::ceil((maxX - minX) / m_cellSize)));
+	m_depth = std::max(1, static_cast<int>(std::ceil((maxZ - minZ) / m_cellSize)));
+
+	size_t cells = static_cast<size_t>(m_width) * m_depth;
+	m_valid.assign(cells, 0);
+	m_height.assign(cells, 0.0f);
+	m_slide.assign(cells, glm::vec2(0.0f));
+	m_slope.assign(cells, 0.0f);
+	m_factor.assign(cells, 1.0f);
+	m_cost.assign(cells, infiniteCost);
+	m_next.assign(cells, -1);
+	m_direction.assign(cells, glm::vec2(0.0f, -1.0f));
+	m_affectedMark.assign(cells, 0);
+
+	for (TrackedObject& tracked : m_objects) tracked.consumed = tracked.object->isConsumed();
+
+	// Una consulta al terreno por celda, repartidas por filas
+	const glm::vec3 gravity(0.0f, -9.8f, 0.0f);
+	ThreadPool::GetInstance().parallelFor(m_depth, 8, [&](size_t begin, size_t end) {
+		for (int z = static_cast<int>(begin); z < static_cast<int>(end); z++) {
+			for (int x = 0; x < m_width; x++) {
+				int cell = z * m_width + x;
+				glm::vec2 center = cellCenter(x, z);
+				GroundSample ground;
+				bool hasGround = false;
+				try {
+					hasGround = navigator.sampleGround(center.x, center.y, ground);
+				}
+				catch (const std::runtime_error&) {
+					// Quad vertical: la celda queda fuera del campo
+				}
+				if (!hasGround || !std::isfinite(ground.height)) continue;
+
+				glm::vec3 normal = glm::normalize(ground.normal);
+				if (!std::isfinite(normal.y)) continue;
+
+				m_valid[cell] = 1;
+				m_height[cell] = ground.height;
+				m_slope[cell] = glm::degrees(std::acos(std::min(1.0f, std::abs(normal.y))));
+				// La misma fuerza con que se desliza el Player, sin importar hacia dónde apunte la normal
+				glm::vec3 slide = glm::cross(normal, glm::cross(gravity, normal));
+				m_slide[cell] = glm::vec2(slide.x, slide.z);
+			}
+		}
+	});
+
+	updateFactors(0, 0, m_width - 1, m_depth - 1);
+
+	// La meta es todo lo que queda pasada la línea de llegada
+	m_queue.clear();
+	for (int z = 0; z < m_depth; z++) {
+		if (cellCenter(0, z).y >= m_finishZ) continue;
+		for (int x = 0; x < m_width; x++) {
+			int cell = z * m_width + x;
+			if (!m_valid[cell]) continue;
+			m_cost[cell] = 0.0f;
+			m_queue.push_back({ 0.0f, cell });
+		}
+	}
+	if (m_queue.empty()) {
+		std::cout << "FlowField: no course cells past the finish line (z < " << m_finishZ << "), steering follows the slope only" << std::endl;
+	}
+	std::make_heap(m_queue.begin(), m_queue.end(), std::greater<QueueEntry>());
+
+	int minCellX = m_width, minCellZ = m_depth, maxCellX = -1, maxCellZ = -1;
+	propagate(minCellX, minCellZ, maxCellX, maxCellZ);
+	updateDirections(0, 0, m_width - 1, m_depth - 1);
+
+	m_buildMillis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+float FlowField::computeFactor(int cell) const {
+	float factor = 1.0f;
+	if (m_slope[cell] > wallSlopeDegrees) factor += wallPenalty;
+
+	glm::vec2 center = cellCenter(cell % m_width, cell / m_width);
+	for (const TrackedObject& tracked : m_objects) {
+		if (tracked.consumed) continue;
+		float radius = tracked.object->getSteeringRadius();
+		if (radius <= 0.0f) continue;
+		glm::vec3 position = tracked.object->getCoursePosition();
+		float distance = glm::length(glm::vec2(position.x, position.z) - center);
+		if (distance >= radius) continue;
+		factor += tracked.object->getSteeringWeight() * (1.0f - distance / radius);
+	}
+	return std::max(minFactor, factor);
+}
+
+float FlowField::edgeCost(int from, int to, float distance) const {
+	return distance * 0.5f * (m_factor[from] + m_factor[to]) + uphillCost * std::max(0.0f, m_height[to] - m_height[from]);
+}
+
+void FlowField::updateFactors(int minX, int minZ, int maxX, int maxZ) {
+	ThreadPool::GetInstance().parallelFor(maxZ - minZ + 1, 16, [&](size_t begin, size_t end) {
+		for (int z = minZ + static_cast<int>(begin); z < minZ + static_cast<int>(end); z++) {
+			for (int x = minX; x <= maxX; x++) {
+				int cell = z * m_width + x;
+				if (m_valid[cell]) m_factor[cell] = computeFactor(cell);
+			}
+		}
+	});
+}
+
+void FlowField::propagate(int& minX, int& minZ, int& maxX, int& maxZ) {
+	// Se propaga desde la meta hacia arriba: al sacar una celda se relajan los vecinos que pueden llegar a ella
+	while (!m_queue.empty()) {
+		std::pop_heap(m_queue.begin(), m_queue.end(), std::greater<QueueEntry>());
+		QueueEntry entry = m_queue.back();
+		m_queue.pop_back();
+		if (entry.cost > m_cost[entry.cell]) continue;
+
+		int cx = entry.cell % m_width;
+		int cz = entry.cell / m_width;
+		for (int i = 0; i < neighborCount; i++) {
+			int nx = cx + neighborX[i];
+			int nz = cz + neighborZ[i];
+			if (nx < 0 || nx >= m_width || nz < 0 || nz >= m_depth) continue;
+			int neighbor = nz * m_width + nx;
+			if (!m_valid[neighbor]) continue;
+
+			float cost = entry.cost + edgeCost(neighbor, entry.cell, neighborDistance[i] * m_cellSize);
+			if (cost >= m_cost[neighbor]) continue;
+			m_cost[neighbor] = cost;
+			m_next[neighbor] = entry.cell;
+			m_queue.push_back({ cost, neighbor });
+			std::push_heap(m_queue.begin(), m_queue.end(), std::greater<QueueEntry>());
+
+			minX = std::min(minX, nx);
+			maxX = std::max(maxX, nx);
+			minZ = std::min(minZ, nz);
+			maxZ = std::max(maxZ, nz);
+		}
+	}
+}
+
+void FlowField::updateDirections(int minX, int minZ, int maxX, int maxZ) {
+	ThreadPool::GetInstance().parallelFor(maxZ - minZ + 1, 16, [&](size_t begin, size_t end) {
+		for (int z = minZ + static_cast<int>(begin); z < minZ + static_cast<int>(end); z++) {
+			for (int x = minX; x <= maxX; x++) {
+				int cell = z * m_width + x;
+				if (!m_valid[cell]) continue;
+
+				// Bajada del costo hacia todos los vecinos más baratos, pesada por cuánto bajan
+				glm::vec2 descent(0.0f);
+				if (std::isfinite(m_cost[cell])) {
+					for (int i = 0; i < neighborCount; i++) {
+						int nx = x + neighborX[i];
+						int nz = z + neighborZ[i];
+						if (nx < 0 || nx >= m_width || nz < 0 || nz >= m_depth) continue;
+						int neighbor = nz * m_width + nx;
+						if (!m_valid[neighbor] || !std::isfinite(m_cost[neighbor])) continue;
+						float drop = (m_cost[cell] - m_cost[neighbor]) / neighborDistance[i];
+						if (drop > 0.0f) descent += drop * glm::vec2(neighborX[i], neighborZ[i]) / neighborDistance[i];
+					}
+				}
+
+				// En la meta (o sin camino a ella) se sigue pista abajo
+				glm::vec2 goal = glm::length(descent) > 1e-6f ? glm::normalize(descent) : glm::vec2(0.0f, -1.0f);
+				glm::vec2 direction = goal + slideBlend * m_slide[cell] / 9.8f;
+				m_direction[cell] = glm::length(direction) > 1e-6f ? glm::normalize(direction) : goal;
+			}
+		}
+	});
+}
+
+size_t FlowField::refresh() {
+	if (!isBuilt()) return 0;
+
+	size_t repaired = 0;
+	for (TrackedObject& tracked : m_objects) {
+		bool consumed = tracked.object->isConsumed();
+		if (consumed == tracked.consumed) continue;
+		tracked.consumed = consumed;
+		if (tracked.object->getSteeringRadius() > 0.0f) {
+			repaired += repair(tracked.object->getCoursePosition(), tracked.object->getSteeringRadius());
+		}
+	}
+	if (repaired > 0) m_lastRepairCells = repaired;
+	return repaired;
+}
+
+size_t FlowField::repair(const glm::vec3& center, float radius) {
+	int minX = std::max(0, static_cast<int>(std::floor((center.x - radius - m_minX) / m_cellSize)));
+	int maxX = std::min(m_width - 1, static_cast<int>(std::floor((center.x + radius - m_minX) / m_cellSize)));
+	int minZ = std::max(0, static_cast<int>(std::floor((center.z - radius - m_minZ) / m_cellSize)));
+	int maxZ = std::min(m_depth - 1, static_cast<int>(std::floor((center.z + radius - m_minZ) / m_cellSize)));
+	if (minX > maxX || minZ > maxZ) return 0;
+
+	updateFactors(minX, minZ, maxX, maxZ);
+
+	// Las celdas de la zona y todas las que llegaban a la meta pasando por ella pierden su costo
+	m_affected.clear();
+	for (int z = minZ; z <= maxZ; z++) {
+		for (int x = minX; x <= maxX; x++) {
+			int cell = z * m_width + x;
+			if (!m_valid[cell]) continue;
+			m_affectedMark[cell] = 1;
+			m_affected.push_back(cell);
+		}
+	}
+	for (size_t i = 0; i < m_affected.size(); i++) {
+		int cell = m_affected[i];
+		int cx = cell % m_width;
+		int cz = cell / m_width;
+		for (int k = 0; k < neighborCount; k++) {
+			int nx = cx + neighborX[k];
+			int nz = cz + neighborZ[k];
+			if (nx < 0 || nx >= m_width || nz < 0 || nz >= m_depth) continue;
+			int neighbor = nz * m_width + nx;
+			if (m_affectedMark[neighbor] || m_next[neighbor] != cell) continue;
+			m_affectedMark[neighbor] = 1;
+			m_affected.push_back(neighbor);
+		}
+	}
+
+	int changedMinX = minX, changedMinZ = minZ, changedMaxX = maxX, changedMaxZ = maxZ;
+	for (int cell : m_affected) {
+		int cx = cell % m_width;
+		int cz = cell / m_width;
+		changedMinX = std::min(changedMinX, cx);
+		changedMaxX = std::max(changedMaxX, cx);
+		changedMinZ = std::min(changedMinZ, cz);
+		changedMaxZ = std::max(changedMaxZ, cz);
+		bool isGoal = cellCenter(cx, cz).y < m_finishZ;
+		m_cost[cell] = isGoal ? 0.0f : infiniteCost;
+		m_next[cell] = -1;
+	}
+
+	// Se parte desde lo que sigue valiendo alrededor; propagate también mejora celdas de afuera
+	// si la zona quedó más barata
+	m_queue.clear();
+	for (int cell : m_affected) {
+		int cx = cell % m_width;
+		int cz = cell / m_width;
+		for (int k = 0; k < neighborCount && m_cost[cell] > 0.0f; k++) {
+			int nx = cx + neighborX[k];
+			int nz = cz + neighborZ[k];
+			if (nx < 0 || nx >= m_width || nz < 0 || nz >= m_depth) continue;
+			int neighbor = nz * m_width + nx;
+			if (m_affectedMark[neighbor] || !m_valid[neighbor] || !std::isfinite(m_cost[neighbor])) continue;
+			float cost = m_cost[neighbor] + edgeCost(cell, neighbor, neighborDistance[k] * m_cellSize);
+			if (cost < m_cost[cell]) {
+				m_cost[cell] = cost;
+				m_next[cell] = neighbor;
+			}
+		}
+		if (std::isfinite(m_cost[cell])) m_queue.push_back({ m_cost[cell], cell });
+	}
+	std::make_heap(m_queue.begin(), m_queue.end(), std::greater<QueueEntry>());
+	propagate(changedMinX, changedMinZ, changedMaxX, changedMaxZ);
+
+	for (int cell : m_affected) m_affectedMark[cell] = 0;
+
+	// La dirección depende de los vecinos, así que se rehace un borde más
+	updateDirections(std::max(0, changedMinX - 1), std::max(0, changedMinZ - 1), std::min(m_width - 1, changedMaxX + 1), std::min(m_depth - 1, changedMaxZ + 1));
+	return m_affected.size();
+}
+
+PlayerInput FlowField::steer(const glm::vec3& position, const glm::vec3& velocity) const {
+	PlayerInput input;
+	glm::vec2 direction;
+	if (!getDirection(position.x, position.z, direction)) return input;
+
+	glm::vec2 heading(velocity.x, velocity.z);
+	float speed = glm::length(heading);
+	if (speed < 0.5f) {
+		// Casi detenido no hay hacia dónde doblar: solo arrancar
+		input.buttons |= PlayerInput::Accelerate;
+		return input;
+	}
+	heading /= speed;
+
+	// Positivo es hacia la izquierda, igual que el steer del Player (rotateY con ángulo positivo)
+	float angle = std::atan2(heading.y * direction.x - heading.x * direction.y, glm::dot(heading, direction));
+	input.steer = static_cast<int8_t>(std::round(std::clamp(angle / fullSteerAngle, -1.0f, 1.0f) * 127.0f));
+	if (std::abs(angle) < 0.15f) input.buttons |= PlayerInput::Accelerate;
+	if (std::abs(angle) > 1.2f) input.buttons |= PlayerInput::Brake;
+	return input;
+}
@@ -0,0 +1,21 @@
+#include "frame_scheduler.h"
+
+const char* framePhaseName(FramePhase phase) {
+	switch (phase) {
+	case FramePhase::Input: return "Input";
+	case FramePhase::Simulation: return "Simulation";
+	case FramePhase::Triggers: return "Triggers";
+	case FramePhase::Events: return "Events";
+	case FramePhase::Presentation: return "Presentation";
+	default: return "Unknown";
+	}
+}
+
+FrameScheduler::FrameScheduler() = default;
+FrameScheduler::~FrameScheduler() = default;
+
+void FrameScheduler::UserStartUp(Mona::World& world) noexcept {}
+
+void FrameScheduler::UserUpdate(Mona::World& world, float timeStep) noexcept {
+	mRunner.runFrame(world, timeStep);
+}
@@ -0,0 +1,29 @@
+#include "loopback_peer.h"
+#include <algorithm>
+
+LoopbackPeer::LoopbackPeer(float latencyMs, float jitterMs, float lossRate, uint32_t seed) :
+    mLatencyMs(latencyMs), mJitterMs(jitterMs), mLossRate(lossRate), mRandom(seed) {}
+
+void LoopbackPeer::send(const InputPacket& packet, double nowMs) {
+    mSent++;
+    if (mUniform(mRandom) < mLossRate) {
+        mDropped++;
+        return;
+    }
+    float jitter = (mUniform(mRandom) * 2.0f - 1.0f) * mJitterMs;
+    mInFlight.push_back({ nowMs + std::max(0.0f, mLatencyMs + jitter), packet });
+}
+
+void LoopbackPeer::receive(double nowMs, std::vector<InputPacket>& out) {
+    // Pocos paquetes en vuelo (latencia / duración de un tick), así que basta una pasada lineal
+    size_t kept = 0;
+    for (size_t i = 0; i < mInFlight.size(); i++) {
+        if (mInFlight[i].arrivalMs <= nowMs) {
+            out.push_back(mInFlight[i].packet);
+        }
+        else {
+            mInFlight[kept++] = mInFlight[i];
+        }
+    }
+    mInFlight.resize(kept);
+}
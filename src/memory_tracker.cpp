@@ -0,0 +1,153 @@
+#include "memory_tracker.h"
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+const char* memoryTagName(MemoryTag tag) {
+    switch (tag) {
+    case MemoryTag::Navigator: return "Navigator";
+    case MemoryTag::Textures: return "Textures";
+    case MemoryTag::Meshes: return "Meshes";
+    case MemoryTag::Audio: return "Audio";
+    case MemoryTag::GameObjects: return "GameObjects";
+    case MemoryTag::Effects: return "Effects";
+    default: return "Unknown";
+    }
+}
+
+bool memoryTagIsEstimate(MemoryTag tag) {
+    return tag == MemoryTag::Textures || tag == MemoryTag::Meshes || tag == MemoryTag::Audio;
+}
+
+MemoryTracker& MemoryTracker::GetInstance() {
+    static MemoryTracker instance;
+    return instance;
+}
+
+void MemoryTracker::recordAllocation(MemoryTag tag, size_t bytes) {
+    Counters& counters = m_counters[static_cast<int>(tag)];
+    size_t live = counters.live.fetch_add(bytes) + bytes;
+    counters.allocations++;
+
+    size_t peak = counters.peak.load();
+    while (live > peak && !counters.peak.compare_exchange_weak(peak, live)) {}
+}
+
+void MemoryTracker::recordFree(MemoryTag tag, size_t bytes) {
+    Counters& counters = m_counters[static_cast<int>(tag)];
+    counters.live.fetch_sub(bytes);
+    counters.frees++;
+}
+
+MemoryStats MemoryTracker::getStats(MemoryTag tag) const {
+    const Counters& counters = m_counters[static_cast<int>(tag)];
+    MemoryStats stats;
+    stats.liveBytes = counters.live.load();
+    stats.peakBytes = counters.peak.load();
+    stats.allocations = counters.allocations.load();
+    stats.frees = counters.frees.load();
+    stats.budgetBytes = counters.budget;
+    return stats;
+}
+
+void MemoryTracker::setBudget(MemoryTag tag, size_t bytes) {
+    m_counters[static_cast<int>(tag)].budget = bytes;
+}
+
+int MemoryTracker::checkBudgets() {
+    int exceeded = 0;
+    for (int i = 0; i < static_cast<int>(MemoryTag::Count); i++) {
+        Counters& counters = m_counters[i];
+        if (counters.budget == 0) continue;
+
+        size_t live = counters.live.load();
+        bool over = live > counters.budget;
+        if (over && !counters.overBudget) {
+            std::cout << "Memory budget exceeded for " << memoryTagName(static_cast<MemoryTag>(i)) << ": "
+                << live << " bytes (budget " << counters.budget << ")" << std::endl;
+        }
+        counters.overBudget = over;
+        if (over) exceeded++;
+    }
+    return exceeded;
+}
+
+bool MemoryTracker::dumpToFile(const std::string& filename) const {
+    std::ofstream out(filename);
+    if (!out) return false;
+
+    out << std::left << std::setw(14) << "subsystem" << std::right
+        << std::setw(14) << "live" << std::setw(14) << "peak"
+        << std::setw(12) << "allocs" << std::setw(12) << "frees" << std::setw(14) << "budget" << "\n";
+    for (int i = 0; i < static_cast<int>(MemoryTag::Count); i++) {
+        MemoryStats stats = getStats(static_cast<MemoryTag>(i));
+        out << std::left << std::setw(14) << memoryTagName(static_cast<MemoryTag>(i)) << std::right
+            << std::setw(14) << stats.liveBytes << std::setw(14) << stats.peakBytes
+            << std::setw(12) << stats.allocations << std::setw(12) << stats.frees
+            << std::setw(14) << stats.budgetBytes
+            << (stats.budgetBytes > 0 && stats.liveBytes > stats.budgetBytes ? "  OVER BUDGET" : "")
+            << (memoryTagIsEstimate(static_cast<MemoryTag>(i)) ? "  (estimated)" : "") << "\n";
+    }
+    return true;
+}
+
+bool MemoryTracker::markTracked(const std::filesystem::path& path) {
+    std::lock_guard<std::mutex> lock(m_pathsMutex);
+    return m_trackedPaths.insert(path.lexically_normal().string()).second;
+}
+
+static uint32_t readBigEndian32(const unsigned char* p) {
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+}
+
+static uint32_t readLittleEndian32(const unsigned char* p) {
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+size_t MemoryTracker::trackTextureFile(const std::filesystem::path& path) {
+    if (!markTracked(path)) return 0;
+
+    // El IHDR de un PNG trae ancho y alto en los bytes 16 a 23; se asume RGBA de 8 bits al decodificar
+    std::ifstream file(path, std::ios::binary);
+    unsigned char header[24];
+    if (!file.read(reinterpret_cast<char*>(header), sizeof(header))) return 0;
+    static const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    if (!std::equal(signature, signature + 8, header)) return 0;
+
+    size_t bytes = size_t(readBigEndian32(header + 16)) * readBigEndian32(header + 20) * 4;
+    recordAllocation(MemoryTag::Textures, bytes);
+    return bytes;
+}
+
+size_t MemoryTracker::trackAudioFile(const std::filesystem::path& path) {
+    if (!markTracked(path)) return 0;
+
+    // Los WAV quedan completos en memoria: lo que pesa es el chunk "data"
+    std::ifstream file(path, std::ios::binary);
+    unsigned char riff[12];
+    if (!file.read(reinterpret_cast<char*>(riff), sizeof(riff))) return 0;
+
+    size_t bytes = 0;
+    unsigned char chunk[8];
+    while (file.read(reinterpret_cast<char*>(chunk), sizeof(chunk))) {
+        uint32_t size = readLittleEndian32(chunk + 4);
+        if (std::equal(chunk, chunk + 4, "data")) {
+            bytes = size;
+            break;
+        }
+        file.seekg(size + (size & 1), std::ios::cur);
+    }
+    if (bytes == 0) {
+        std::error_code error;
+        bytes = static_cast<size_t>(std::filesystem::file_size(path, error));
+        if (error) return 0;
+    }
+    recordAllocation(MemoryTag::Audio, bytes);
+    return bytes;
+}
+
+size_t MemoryTracker::trackMeshFile(const std::filesystem::path& path, size_t bytes) {
+    if (!markTracked(path)) return 0;
+    recordAllocation(MemoryTag::Meshes, bytes);
+    return bytes;
+}
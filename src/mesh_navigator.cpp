@@ -1,4 +1,10 @@
 #include "mesh_navigator.h"
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+#include "obj_reader.h"
+#include "memory_tracker.h"
+#include <cctype>
 #include <iostream>
 
 // Función auxiliar para verificar si un punto está dentro de un triángulo en el plano XZ
@@ -44,86 +50,126 @@ float interpolateHeightInTriangle(const glm::vec2& p, const glm::vec3& v0, const
 
 
 
-MeshNavigator::MeshNavigator(std::string filename, float scale) : m_filename(filename), m_scale(scale) {}
+// Agrega el quad si ninguno de sus vértices es NaN
+static bool addQuad(std::vector<Quad*>& quads, size_t faceIndex, const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2, const glm::vec3& v3) {
+    // Verificar si algún valor es NaN
+    if (glm::isnan(v0.x) || glm::isnan(v0.y) || glm::isnan(v0.z) ||
+        glm::isnan(v1.x) || glm::isnan(v1.y) || glm::isnan(v1.z) ||
+        glm::isnan(v2.x) || glm::isnan(v2.y) || glm::isnan(v2.z) ||
+        glm::isnan(v3.x) || glm::isnan(v3.y) || glm::isnan(v3.z)) {
 
+        std::cout << "NaN detected in face " << faceIndex << " vertices:" << std::endl;
+        std::cout << "v0: (" << v0.x << ", " << v0.y << ", " << v0.z << ")" << std::endl;
+        std::cout << "v1: (" << v1.x << ", " << v1.y << ", " << v1.z << ")" << std::endl;
+        std::cout << "v2: (" << v2.x << ", " << v2.y << ", " << v2.z << ")" << std::endl;
+        std::cout << "v3: (" << v3.x << ", " << v3.y << ", " << v3.z << ")" << std::endl;
+        return false; // Saltar este quad si tiene valores NaN
+    }
 
+    // Crear y agregar el quad al vector quads
+    quads.push_back(new Quad(v0, v1, v2, v3));
+    return true;
+}
 
+static bool hasObjExtension(const std::string& filename) {
+    if (filename.size() < 4) return false;
+    std::string extension = filename.substr(filename.size() - 4);
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return extension == ".obj";
+}
 
+// Los OBJ pasan por el lector propio (mapeado a memoria y en paralelo); el resto sigue usando Assimp
+std::vector<Quad*> loadQuadsFromFile(const std::string& filename, float scale, QuadLoadReport* report) {
+    std::vector<Quad*> quads;
+    QuadLoadReport counts;
 
-void MeshNavigator::loadMeshToMap(const std::string& filename) {
-    Assimp::Importer importer;
-    const aiScene* scene = importer.ReadFile(filename, aiProcess_JoinIdenticalVertices);
-    if (!scene || !scene->HasMeshes()) {
-        throw std::runtime_error("Failed to load mesh");
-    }
+    if (hasObjExtension(filename)) {
+        // El parse es memoria del navegador, no de las mallas que sube el motor
+        BasicObjData<MemoryTag::Navigator> obj = readObjFile<MemoryTag::Navigator>(filename);
+        if (obj.positions.empty()) {
+            throw std::runtime_error("Failed to load mesh");
+        }
 
-    for (unsigned int i = 0; i < scene->mMeshes[0]->mNumFaces; i++) {
-        auto face = scene->mMeshes[0]->mFaces[i];
-        if (face.mNumIndices != 4) continue; // Asegurar que es un quad
-
-        glm::vec3 v0(scene->mMeshes[0]->mVertices[face.mIndices[0]].x * m_scale,
-            scene->mMeshes[0]->mVertices[face.mIndices[0]].y * m_scale,
-            scene->mMeshes[0]->mVertices[face.mIndices[0]].z * m_scale);
-        glm::vec3 v1(scene->mMeshes[0]->mVertices[face.mIndices[1]].x * m_scale,
-            scene->mMeshes[0]->mVertices[face.mIndices[1]].y * m_scale,
-            scene->mMeshes[0]->mVertices[face.mIndices[1]].z * m_scale);
-        glm::vec3 v2(scene->mMeshes[0]->mVertices[face.mIndices[2]].x * m_scale,
-            scene->mMeshes[0]->mVertices[face.mIndices[2]].y * m_scale,
-            scene->mMeshes[0]->mVertices[face.mIndices[2]].z * m_scale);
-        glm::vec3 v3(scene->mMeshes[0]->mVertices[face.mIndices[3]].x * m_scale,
-            scene->mMeshes[0]->mVertices[face.mIndices[3]].y * m_scale,
-            scene->mMeshes[0]->mVertices[face.mIndices[3]].z * m_scale);
-
-        // Verificar si algún valor es NaN
-        if (glm::isnan(v0.x) || glm::isnan(v0.y) || glm::isnan(v0.z) ||
-            glm::isnan(v1.x) || glm::isnan(v1.y) || glm::isnan(v1.z) ||
-            glm::isnan(v2.x) || glm::isnan(v2.y) || glm::isnan(v2.z) ||
-            glm::isnan(v3.x) || glm::isnan(v3.y) || glm::isnan(v3.z)) {
-
-            std::cout << "NaN detected in face " << i << " vertices:" << std::endl;
-            std::cout << "v0: (" << v0.x << ", " << v0.y << ", " << v0.z << ")" << std::endl;
-            std::cout << "v1: (" << v1.x << ", " << v1.y << ", " << v1.z << ")" << std::endl;
-            std::cout << "v2: (" << v2.x << ", " << v2.y << ", " << v2.z << ")" << std::endl;
-            std::cout << "v3: (" << v3.x << ", " << v3.y << ", " << v3.z << ")" << std::endl;
-            continue; // Saltar este quad si tiene valores NaN
+        counts.faces = obj.faces.size() + obj.skippedFaces;
+        counts.nonQuadFaces = obj.skippedFaces;
+        counts.malformedNumbers = obj.malformedNumbers;
+        quads.reserve(obj.faces.size());
+        for (size_t i = 0; i < obj.faces.size(); i++) {
+            const ObjFace& face = obj.faces[i];
+            if (face.count != 4) { // Asegurar que es un quad
+                counts.nonQuadFaces++;
+                continue;
+            }
+
+            glm::vec3 v[4];
+            bool valid = true;
+            for (int c = 0; c < 4; c++) {
+                int32_t index = face.corners[c].position;
+                if (index < 0 || index >= static_cast<int32_t>(obj.positions.size())) {
+                    valid = false;
+                    break;
+                }
+                v[c] = obj.positions[index] * scale;
+            }
+            if (!valid) {
+                counts.badIndexFaces++;
+                continue;
+            }
+
+            if (!addQuad(quads, i, v[0], v[1], v[2], v[3])) counts.nanFaces++;
+        }
+    }
+    else {
+        Assimp::Importer importer;
+        const aiScene* scene = importer.ReadFile(filename, aiProcess_JoinIdenticalVertices);
+        if (!scene || !scene->HasMeshes()) {
+            throw std::runtime_error("Failed to load mesh");
         }
-        
-        
-        // Crear y agregar el quad al vector quads
-        Quad* newQuad = new Quad(v0, v1, v2, v3);
-        quads.push_back(newQuad);
-
-        //// Mensaje de depuración para verificar los vértices del quad
-        //std::cout << "Quad " << i << " vertices:" << std::endl;
-        //std::cout << "v0: (" << quads[i]->v0.x << ", " << quads[i]->v0.y << ", " << quads[i]->v0.z << ")" << std::endl;
-        //std::cout << "v1: (" << quads[i]->v1.x << ", " << quads[i]->v1.y << ", " << quads[i]->v1.z << ")" << std::endl;
-        //std::cout << "v2: (" << quads[i]->v2.x << ", " << quads[i]->v2.y << ", " << quads[i]->v2.z << ")" << std::endl;
-        //std::cout << "v3: (" << quads[i]->v3.x << ", " << quads[i]->v3.y << ", " << quads[i]->v3.z << ")" << std::endl;
 
+        counts.faces = scene->mMeshes[0]->mNumFaces;
+        for (unsigned int i = 0; i < scene->mMeshes[0]->mNumFaces; i++) {
+            auto face = scene->mMeshes[0]->mFaces[i];
+            if (face.mNumIndices != 4) { // Asegurar que es un quad
+                counts.nonQuadFaces++;
+                continue;
+            }
+
+            glm::vec3 v0(scene->mMeshes[0]->mVertices[face.mIndices[0]].x * scale,
+                scene->mMeshes[0]->mVertices[face.mIndices[0]].y * scale,
+                scene->mMeshes[0]->mVertices[face.mIndices[0]].z * scale);
+            glm::vec3 v1(scene->mMeshes[0]->mVertices[face.mIndices[1]].x * scale,
+                scene->mMeshes[0]->mVertices[face.mIndices[1]].y * scale,
+                scene->mMeshes[0]->mVertices[face.mIndices[1]].z * scale);
+            glm::vec3 v2(scene->mMeshes[0]->mVertices[face.mIndices[2]].x * scale,
+                scene->mMeshes[0]->mVertices[face.mIndices[2]].y * scale,
+                scene->mMeshes[0]->mVertices[face.mIndices[2]].z * scale);
+            glm::vec3 v3(scene->mMeshes[0]->mVertices[face.mIndices[3]].x * scale,
+                scene->mMeshes[0]->mVertices[face.mIndices[3]].y * scale,
+                scene->mMeshes[0]->mVertices[face.mIndices[3]].z * scale);
+
+            if (!addQuad(quads, i, v0, v1, v2, v3)) counts.nanFaces++;
+        }
     }
-}
 
+    counts.quads = quads.size();
+    if (report != nullptr) *report = counts;
+    return quads;
+}
 
-Quad* MeshNavigator::getQuadAtPosition(float x, float z) {
-    for (int i = 0; i < quads.size(); i++) {
-        glm::vec3 v0 = quads[i]->v0;
-        glm::vec3 v1 = quads[i]->v1;
-        glm::vec3 v2 = quads[i]->v2;
-        glm::vec3 v3 = quads[i]->v3;
 
-        float minx = std::min({ v0.x, v1.x, v2.x, v3.x });
-        float maxx = std::max({ v0.x, v1.x, v2.x, v3.x });
-        float minz = std::min({ v0.z, v1.z, v2.z, v3.z });
-        float maxz = std::max({ v0.z, v1.z, v2.z, v3.z });
+void* Quad::operator new(size_t size) {
+    void* p = ::operator new(size);
+    MemoryTracker::GetInstance().recordAllocation(MemoryTag::Navigator, size);
+    return p;
+}
 
-        /*std::cout << "minx: " << minx << std::endl;
-        std::cout << "maxx: " << maxx << std::endl;
-        std::cout << "minz: " << minz << std::endl;
-        std::cout << "maxz: " << maxz << std::endl;*/
+void Quad::operator delete(void* p, size_t size) {
+    MemoryTracker::GetInstance().recordFree(MemoryTag::Navigator, size);
+    ::operator delete(p);
+}
 
-        if ((minx <= x && x <= maxx) && (minz <= z && z <= maxz)) return quads[i];
-    }
-    return nullptr;
+bool isPointInQuadXZ(const glm::vec2& positionXZ, const Quad& quad) {
+    return isPointInTriangleXZ(positionXZ, quad.v0, quad.v1, quad.v2) || isPointInTriangleXZ(positionXZ, quad.v0, quad.v2, quad.v3);
 }
 
 // Función principal para interpolar la altura dado un punto y un quad
@@ -131,8 +177,8 @@ float getHeightInQuad(const glm::vec2& positionXZ, Quad* quad) {
     if (isPointInTriangleXZ(positionXZ, quad->v0, quad->v1, quad->v2)) {
         return interpolateHeightInTriangle(positionXZ, quad->v0, quad->v1, quad->v2);
     }
-    else if (isPointInTriangleXZ(positionXZ, quad->v0, quad->v1, quad->v2)) {
-        return interpolateHeightInTriangle(positionXZ, quad->v0, quad->v1, quad->v2);
+    else if (isPointInTriangleXZ(positionXZ, quad->v0, quad->v2, quad->v3)) {
+        return interpolateHeightInTriangle(positionXZ, quad->v0, quad->v2, quad->v3);
     }
     else {
         // El punto está fuera del quad
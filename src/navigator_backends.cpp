@@ -0,0 +1,159 @@
+#include "navigator_backends.h"
+#include <limits>
+
+QuadBoundsXZ computeQuadBoundsXZ(const Quad& quad) {
+    QuadBoundsXZ bounds;
+    bounds.minx = std::min({ quad.v0.x, quad.v1.x, quad.v2.x, quad.v3.x });
+    bounds.maxx = std::max({ quad.v0.x, quad.v1.x, quad.v2.x, quad.v3.x });
+    bounds.minz = std::min({ quad.v0.z, quad.v1.z, quad.v2.z, quad.v3.z });
+    bounds.maxz = std::max({ quad.v0.z, quad.v1.z, quad.v2.z, quad.v3.z });
+    return bounds;
+}
+
+
+
+void LinearNavBackend::build(const std::vector<Quad*>& quads) {
+    m_quads.assign(quads.begin(), quads.end());
+    m_bounds.clear();
+    m_bounds.reserve(quads.size());
+    for (Quad* quad : quads) {
+        m_bounds.push_back(computeQuadBoundsXZ(*quad));
+    }
+}
+
+
+
+void GridNavBackend::build(const std::vector<Quad*>& quads) {
+    const int maxCellsPerAxis = 2048;
+
+    m_quads.assign(quads.begin(), quads.end());
+    m_bounds.clear();
+    m_bounds.reserve(quads.size());
+    m_cellStart.clear();
+    m_cellQuads.clear();
+    m_cols = 0;
+    m_rows = 0;
+    if (quads.empty()) return;
+
+    // Bordes del recorrido y tamaño medio de un quad, que se usa como tamaño de celda
+    m_courseBounds = { std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest(),
+        std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest() };
+    double extentSum = 0.0;
+    for (Quad* quad : quads) {
+        QuadBoundsXZ b = computeQuadBoundsXZ(*quad);
+        m_bounds.push_back(b);
+        m_courseBounds.minx = std::min(m_courseBounds.minx, b.minx);
+        m_courseBounds.maxx = std::max(m_courseBounds.maxx, b.maxx);
+        m_courseBounds.minz = std::min(m_courseBounds.minz, b.minz);
+        m_courseBounds.maxz = std::max(m_courseBounds.maxz, b.maxz);
+        extentSum += std::max(b.maxx - b.minx, b.maxz - b.minz);
+    }
+
+    float width = m_courseBounds.maxx - m_courseBounds.minx;
+    float depth = m_courseBounds.maxz - m_courseBounds.minz;
+    m_cellSize = static_cast<float>(extentSum / quads.size());
+    m_cellSize = std::max({ m_cellSize, width / maxCellsPerAxis, depth / maxCellsPerAxis, 1e-4f });
+    m_invCellSize = 1.0f / m_cellSize;
+    m_cols = static_cast<int>(width * m_invCellSize) + 1;
+    m_rows = static_cast<int>(depth * m_invCellSize) + 1;
+
+    auto cellRange = [this](const QuadBoundsXZ& b, int& x0, int& x1, int& z0, int& z1) {
+        x0 = std::clamp(static_cast<int>((b.minx - m_courseBounds.minx) * m_invCellSize), 0, m_cols - 1);
+        x1 = std::clamp(static_cast<int>((b.maxx - m_courseBounds.minx) * m_invCellSize), 0, m_cols - 1);
+        z0 = std::clamp(static_cast<int>((b.minz - m_courseBounds.minz) * m_invCellSize), 0, m_rows - 1);
+        z1 = std::clamp(static_cast<int>((b.maxz - m_courseBounds.minz) * m_invCellSize), 0, m_rows - 1);
+    };
+
+    // Dos pasadas (contar y luego llenar) para dejar las listas contiguas en un solo arreglo
+    m_cellStart.assign(static_cast<size_t>(m_cols) * m_rows + 1, 0);
+    for (const QuadBoundsXZ& b : m_bounds) {
+        int x0, x1, z0, z1;
+        cellRange(b, x0, x1, z0, z1);
+        for (int cz = z0; cz <= z1; cz++) {
+            for (int cx = x0; cx <= x1; cx++) {
+                m_cellStart[cz * m_cols + cx + 1]++;
+            }
+        }
+    }
+    for (size_t i = 1; i < m_cellStart.size(); i++) {
+        m_cellStart[i] += m_cellStart[i - 1];
+    }
+
+    m_cellQuads.resize(m_cellStart.back());
+    std::vector<uint32_t> cursor(m_cellStart.begin(), m_cellStart.end() - 1);
+    for (uint32_t q = 0; q < m_bounds.size(); q++) {
+        int x0, x1, z0, z1;
+        cellRange(m_bounds[q], x0, x1, z0, z1);
+        for (int cz = z0; cz <= z1; cz++) {
+            for (int cx = x0; cx <= x1; cx++) {
+                m_cellQuads[cursor[cz * m_cols + cx]++] = q;
+            }
+        }
+    }
+}
+
+
+
+void HeightfieldNavBackend::build(const std::vector<Quad*>& quads) {
+    m_heights.clear();
+    m_cellNormal.clear();
+    m_cellQuad.clear();
+    m_cellInside.clear();
+    m_cols = 0;
+    m_rows = 0;
+    if (quads.empty()) return;
+
+    // La grilla de quads se usa para muestrear el terreno y después para las consultas cerca de los bordes
+    m_grid.build(quads);
+    const QuadBoundsXZ& bounds = m_grid.getCourseBounds();
+
+    // El tamaño sale del lado corto de los quads: con quads alargados, el lado largo dejaría celdas más
+    // anchas que un quad y casi ninguna caería entera dentro del suyo
+    const int maxCellsPerAxis = 2048;
+    double shortSideSum = 0.0;
+    for (Quad* quad : quads) {
+        QuadBoundsXZ b = computeQuadBoundsXZ(*quad);
+        shortSideSum += std::min(b.maxx - b.minx, b.maxz - b.minz);
+    }
+    float cellSize = static_cast<float>(shortSideSum / quads.size()) / std::max(1, m_subdivisions);
+    cellSize = std::max({ cellSize, (bounds.maxx - bounds.minx) / maxCellsPerAxis, (bounds.maxz - bounds.minz) / maxCellsPerAxis, 1e-4f });
+    m_originX = bounds.minx;
+    m_originZ = bounds.minz;
+    m_invCellSize = 1.0f / cellSize;
+    m_cols = static_cast<int>((bounds.maxx - bounds.minx) * m_invCellSize) + 1;
+    m_rows = static_cast<int>((bounds.maxz - bounds.minz) * m_invCellSize) + 1;
+
+    int stride = m_cols + 1;
+    m_heights.assign(static_cast<size_t>(stride) * (m_rows + 1), std::numeric_limits<float>::quiet_NaN());
+    for (int nz = 0; nz <= m_rows; nz++) {
+        for (int nx = 0; nx <= m_cols; nx++) {
+            GroundSample sample;
+            try {
+                if (m_grid.sample(m_originX + nx * cellSize, m_originZ + nz * cellSize, sample)) {
+                    m_heights[nz * stride + nx] = sample.height;
+                }
+            }
+            catch (const std::runtime_error&) {
+                // Quad vertical: el nodo queda sin altura
+            }
+        }
+    }
+
+    m_cellQuad.assign(static_cast<size_t>(m_cols) * m_rows, nullptr);
+    m_cellNormal.assign(static_cast<size_t>(m_cols) * m_rows, glm::vec3(0.0f, 1.0f, 0.0f));
+    m_cellInside.assign(static_cast<size_t>(m_cols) * m_rows, 0);
+    for (int cz = 0; cz < m_rows; cz++) {
+        for (int cx = 0; cx < m_cols; cx++) {
+            Quad* quad = m_grid.findQuad(m_originX + (cx + 0.5f) * cellSize, m_originZ + (cz + 0.5f) * cellSize);
+            if (quad == nullptr) continue;
+            m_cellQuad[cz * m_cols + cx] = quad;
+            m_cellNormal[cz * m_cols + cx] = quad->calculateQuadNormal();
+
+            // Con las cuatro esquinas dentro del quad (convexo) la celda entera lo está
+            float x0 = m_originX + cx * cellSize, x1 = x0 + cellSize;
+            float z0 = m_originZ + cz * cellSize, z1 = z0 + cellSize;
+            m_cellInside[cz * m_cols + cx] = isPointInQuadXZ(glm::vec2(x0, z0), *quad) && isPointInQuadXZ(glm::vec2(x1, z0), *quad) &&
+                isPointInQuadXZ(glm::vec2(x0, z1), *quad) && isPointInQuadXZ(glm::vec2(x1, z1), *quad);
+        }
+    }
+}
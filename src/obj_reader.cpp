@@ -0,0 +1,372 @@
+#include "obj_reader.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Archivo de solo lectura mapeado a memoria; se desmapea al destruirse
+class MappedFile {
+public:
+    MappedFile(const std::string& filename) {
+#if defined(_WIN32)
+        m_file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (m_file == INVALID_HANDLE_VALUE) throw std::runtime_error("Failed to open " + filename);
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(m_file, &size)) throw std::runtime_error("Failed to stat " + filename);
+        m_size = static_cast<size_t>(size.QuadPart);
+        if (m_size == 0) return;
+        m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (m_mapping == nullptr) throw std::runtime_error("Failed to map " + filename);
+        m_data = static_cast<const char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+        m_fd = open(filename.c_str(), O_RDONLY);
+        if (m_fd < 0) throw std::runtime_error("Failed to open " + filename);
+        struct stat info;
+        if (fstat(m_fd, &info) != 0) throw std::runtime_error("Failed to stat " + filename);
+        m_size = static_cast<size_t>(info.st_size);
+        if (m_size == 0) return;
+        void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+        if (data == MAP_FAILED) throw std::runtime_error("Failed to map " + filename);
+        m_data = static_cast<const char*>(data);
+#endif
+    }
+
+    ~MappedFile() {
+#if defined(_WIN32)
+        if (m_data != nullptr) UnmapViewOfFile(m_data);
+        if (m_mapping != nullptr) CloseHandle(m_mapping);
+        if (m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+#else
+        if (m_data != nullptr) munmap(const_cast<char*>(m_data), m_size);
+        if (m_fd >= 0) close(m_fd);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+private:
+    const char* m_data = nullptr;
+    size_t m_size = 0;
+#if defined(_WIN32)
+    HANDLE m_file = INVALID_HANDLE_VALUE;
+    HANDLE m_mapping = nullptr;
+#else
+    int m_fd = -1;
+#endif
+};
+
+
+enum class RecordType { Other, Position, Texcoord, Normal, Face };
+
+struct ChunkCounts {
+    size_t positions = 0;
+    size_t texcoords = 0;
+    size_t normals = 0;
+    size_t faces = 0;
+};
+
+inline bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline const char* skipBlanks(const char* p, const char* end) {
+    while (p < end && isBlank(*p)) p++;
+    return p;
+}
+
+inline const char* nextLine(const char* p, const char* end) {
+    const char* newline = static_cast<const char*>(memchr(p, '\n', end - p));
+    return newline == nullptr ? end : newline + 1;
+}
+
+// Mira el comienzo de la línea y deja p justo después de la palabra clave
+inline RecordType recordType(const char*& p, const char* end) {
+    p = skipBlanks(p, end);
+    if (end - p < 2) return RecordType::Other;
+    if (p[0] == 'v') {
+        if (isBlank(p[1])) { p += 2; return RecordType::Position; }
+        if (end - p >= 3 && isBlank(p[2])) {
+            if (p[1] == 't') { p += 3; return RecordType::Texcoord; }
+            if (p[1] == 'n') { p += 3; return RecordType::Normal; }
+        }
+    }
+    else if (p[0] == 'f' && isBlank(p[1])) {
+        p += 2;
+        return RecordType::Face;
+    }
+    return RecordType::Other;
+}
+
+// Un número que no se puede leer queda en NaN y se cuenta en malformed: la cara que lo use se descarta
+// como cualquier otra con NaN, en vez de quedar con un vértice en 0
+inline float parseFloat(const char*& p, const char* end, size_t& malformed) {
+    p = skipBlanks(p, end);
+    if (p < end && *p == '+') p++;
+    float value = 0.0f;
+    auto result = std::from_chars(p, end, value);
+    if (result.ec != std::errc()) {
+        malformed++;
+        value = std::numeric_limits<float>::quiet_NaN();
+        while (p < end && !isBlank(*p) && *p != '\n') p++;
+        return value;
+    }
+    p = result.ptr;
+    return value;
+}
+
+inline bool parseInt(const char*& p, const char* end, int32_t& value) {
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        p++;
+    }
+    if (p >= end || *p < '0' || *p > '9') return false;
+    int32_t v = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        v = v * 10 + (*p - '0');
+        p++;
+    }
+    value = negative ? -v : v;
+    return true;
+}
+
+// Índice OBJ (base 1, o negativo relativo al último definido) a base 0
+inline int32_t resolveIndex(int32_t index, size_t definedSoFar) {
+    return index > 0 ? index - 1 : static_cast<int32_t>(definedSoFar) + index;
+}
+
+void countChunk(const char* begin, const char* end, ChunkCounts& counts) {
+    for (const char* line = begin; line < end; line = nextLine(line, end)) {
+        const char* p = line;
+        switch (recordType(p, end)) {
+        case RecordType::Position: counts.positions++; break;
+        case RecordType::Texcoord: counts.texcoords++; break;
+        case RecordType::Normal: counts.normals++; break;
+        case RecordType::Face: counts.faces++; break;
+        default: break;
+        }
+    }
+}
+
+struct ChunkResult {
+    size_t skippedFaces = 0;
+    size_t malformedNumbers = 0;
+};
+
+// Segunda pasada: escribe directo en los arreglos finales a partir de los offsets del trozo
+template <typename Data>
+ChunkResult parseChunk(const char* begin, const char* end, const ChunkCounts& base, Data& out) {
+    size_t positions = base.positions;
+    size_t texcoords = base.texcoords;
+    size_t normals = base.normals;
+    size_t faces = base.faces;
+    size_t skipped = 0;
+    size_t malformed = 0;
+
+    for (const char* line = begin; line < end; ) {
+        const char* lineEnd = nextLine(line, end);
+        const char* p = line;
+        switch (recordType(p, lineEnd)) {
+        case RecordType::Position: {
+            glm::vec3& v = out.positions[positions++];
+            v.x = parseFloat(p, lineEnd, malformed);
+            v.y = parseFloat(p, lineEnd, malformed);
+            v.z = parseFloat(p, lineEnd, malformed);
+            break;
+        }
+        case RecordType::Texcoord: {
+            glm::vec2& t = out.texcoords[texcoords++];
+            t.x = parseFloat(p, lineEnd, malformed);
+            t.y = parseFloat(p, lineEnd, malformed);
+            break;
+        }
+        case RecordType::Normal: {
+            glm::vec3& n = out.normals[normals++];
+            n.x = parseFloat(p, lineEnd, malformed);
+            n.y = parseFloat(p, lineEnd, malformed);
+            n.z = parseFloat(p, lineEnd, malformed);
+            break;
+        }
+        case RecordType::Face: {
+            ObjFace& face = out.faces[faces++];
+            face = ObjFace();
+            int corners = 0;
+            while (true) {
+                p = skipBlanks(p, lineEnd);
+                int32_t index;
+                if (!parseInt(p, lineEnd, index)) break;
+                ObjIndex corner;
+                corner.position = resolveIndex(index, positions);
+                if (p < lineEnd && *p == '/') {
+                    p++;
+                    if (parseInt(p, lineEnd, index)) corner.texcoord = resolveIndex(index, texcoords);
+                    if (p < lineEnd && *p == '/') {
+                        p++;
+                        if (parseInt(p, lineEnd, index)) corner.normal = resolveIndex(index, normals);
+                    }
+                }
+                if (corners < 4) face.corners[corners] = corner;
+                corners++;
+            }
+            if (corners < 3 || corners > 4) {
+                // Queda como cara vacía; parseObj la saca al final
+                face.count = 0;
+                skipped++;
+            }
+            else {
+                face.count = static_cast<uint8_t>(corners);
+            }
+            break;
+        }
+        default:
+            break;
+        }
+        line = lineEnd;
+    }
+    return { skipped, malformed };
+}
+
+// Esquinas de una línea de cara; p queda después de la palabra clave
+inline int countCorners(const char* p, const char* end) {
+    int corners = 0;
+    while (true) {
+        p = skipBlanks(p, end);
+        if (p >= end || *p == '\n') break;
+        corners++;
+        while (p < end && !isBlank(*p) && *p != '\n') p++;
+    }
+    return corners;
+}
+
+// Trozos de al menos 256 KB, alineados al final de línea para que ninguna línea quede partida
+std::vector<const char*> splitChunks(const char* data, size_t size) {
+    const size_t minChunkSize = 256 * 1024;
+    size_t chunkCount = std::max<size_t>(1, std::min<size_t>(ThreadPool::GetInstance().getWorkerCount() * 4, size / minChunkSize));
+    std::vector<const char*> bounds(chunkCount + 1);
+    bounds[0] = data;
+    bounds[chunkCount] = data + size;
+    for (size_t i = 1; i < chunkCount; i++) {
+        const char* guess = std::max(bounds[i - 1], data + size * i / chunkCount);
+        bounds[i] = guess == data ? data : nextLine(guess - 1, data + size);
+    }
+    return bounds;
+}
+
+}
+
+
+template <MemoryTag Tag>
+BasicObjData<Tag> parseObj(const char* data, size_t size) {
+    BasicObjData<Tag> result;
+    if (size == 0) return result;
+
+    auto& pool = ThreadPool::GetInstance();
+    std::vector<const char*> bounds = splitChunks(data, size);
+    size_t chunkCount = bounds.size() - 1;
+
+    std::vector<ChunkCounts> counts(chunkCount);
+    pool.parallelFor(chunkCount, 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) countChunk(bounds[i], bounds[i + 1], counts[i]);
+    });
+
+    // Suma prefija: cada trozo sabe dónde escribir y cuántos vértices se definieron antes que él
+    std::vector<ChunkCounts> offsets(chunkCount);
+    ChunkCounts total;
+    for (size_t i = 0; i < chunkCount; i++) {
+        offsets[i] = total;
+        total.positions += counts[i].positions;
+        total.texcoords += counts[i].texcoords;
+        total.normals += counts[i].normals;
+        total.faces += counts[i].faces;
+    }
+    result.positions.resize(total.positions);
+    result.texcoords.resize(total.texcoords);
+    result.normals.resize(total.normals);
+    result.faces.resize(total.faces);
+
+    std::vector<ChunkResult> chunkResults(chunkCount);
+    pool.parallelFor(chunkCount, 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) chunkResults[i] = parseChunk(bounds[i], bounds[i + 1], offsets[i], result);
+    });
+
+    for (const ChunkResult& r : chunkResults) {
+        result.skippedFaces += r.skippedFaces;
+        result.malformedNumbers += r.malformedNumbers;
+    }
+    if (result.skippedFaces > 0) {
+        result.faces.erase(std::remove_if(result.faces.begin(), result.faces.end(), [](const ObjFace& face) { return face.count == 0; }), result.faces.end());
+    }
+    return result;
+}
+
+template <MemoryTag Tag>
+BasicObjData<Tag> readObjFile(const std::string& filename) {
+    MappedFile file(filename);
+    return parseObj<Tag>(file.data(), file.size());
+}
+
+template BasicObjData<MemoryTag::Meshes> parseObj<MemoryTag::Meshes>(const char* data, size_t size);
+template BasicObjData<MemoryTag::Navigator> parseObj<MemoryTag::Navigator>(const char* data, size_t size);
+template BasicObjData<MemoryTag::Meshes> readObjFile<MemoryTag::Meshes>(const std::string& filename);
+template BasicObjData<MemoryTag::Navigator> readObjFile<MemoryTag::Navigator>(const std::string& filename);
+
+ObjFaceCounts countObjFaces(const std::string& filename) {
+    MappedFile file(filename);
+    ObjFaceCounts total;
+    if (file.size() == 0) return total;
+
+    std::vector<const char*> bounds = splitChunks(file.data(), file.size());
+    std::vector<ObjFaceCounts> counts(bounds.size() - 1);
+    ThreadPool::GetInstance().parallelFor(counts.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            for (const char* line = bounds[i]; line < bounds[i + 1]; ) {
+                const char* lineEnd = nextLine(line, bounds[i + 1]);
+                const char* p = line;
+                if (recordType(p, lineEnd) == RecordType::Face) {
+                    // Igual que parseObj, las caras de menos de 3 o más de 4 vértices no cuentan
+                    int corners = countCorners(p, lineEnd);
+                    if (corners >= 3 && corners <= 4) {
+                        counts[i].faces++;
+                        counts[i].corners += corners;
+                        counts[i].triangles += corners - 2;
+                    }
+                }
+                line = lineEnd;
+            }
+        }
+    });
+
+    for (const ObjFaceCounts& c : counts) {
+        total.faces += c.faces;
+        total.corners += c.corners;
+        total.triangles += c.triangles;
+    }
+    return total;
+}
+
+size_t estimateObjMeshBytes(const std::string& filename) {
+    // El motor triangula y no comparte vértices entre caras: cada esquina lleva
+    // posición, normal, uv, tangente y bitangente, más tres índices por triángulo
+    ObjFaceCounts counts = countObjFaces(filename);
+    return counts.corners * 14 * sizeof(float) + counts.triangles * 3 * sizeof(uint32_t);
+}
@@ -1,7 +1,7 @@
 #include "obstacle.h"
 
 
-Obstacle::Obstacle(glm::vec3 initPos, Mona::GameObjectHandle<Player> player, float scale) : mInitPos(initPos), mPlayer(player), mScale(scale) {}
+Obstacle::Obstacle(glm::vec3 initPos, Mona::GameObjectHandle<CourseActivation> activation, float scale) : mInitPos(initPos), mScale(scale), mActivation(activation) {}
 Obstacle::~Obstacle() = default;
 
 void Obstacle::UserStartUp(Mona::World& world) noexcept {
@@ -12,30 +12,31 @@ void Obstacle::UserStartUp(Mona::World& world) noexcept {
 	auto noseMaterial = std::static_pointer_cast<Mona::DiffuseFlatMaterial>(world.CreateMaterial(Mona::MaterialType::DiffuseFlat));
 	noseMaterial->SetDiffuseColor(glm::vec3(0.8f, 0.0f, 0.0f));
 
-	auto sphere1 = world.CreateGameObject<Mona::GameObject>();
-	world.AddComponent<Mona::TransformComponent>(sphere1, mInitPos + glm::vec3(0.0f, 1.0f * mScale, 0.0f), glm::fquat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(1.0f * mScale));
-	world.AddComponent<Mona::StaticMeshComponent>(sphere1, meshManager.LoadMesh(Mona::Mesh::PrimitiveType::Sphere), bodyMaterial);
+	addMeshPart(world, mInitPos + glm::vec3(0.0f, 1.0f * mScale, 0.0f), glm::vec3(1.0f * mScale), meshManager.LoadMesh(Mona::Mesh::PrimitiveType::Sphere), bodyMaterial);
 
-	auto sphere2 = world.CreateGameObject<Mona::GameObject>();
-	world.AddComponent<Mona::TransformComponent>(sphere2, mInitPos + glm::vec3(0.0f, 2.6f * mScale, 0.0f), glm::fquat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(0.6f * mScale));
-	world.AddComponent<Mona::StaticMeshComponent>(sphere2, meshManager.LoadMesh(Mona::Mesh::PrimitiveType::Sphere), bodyMaterial);
+	addMeshPart(world, mInitPos + glm::vec3(0.0f, 2.6f * mScale, 0.0f), glm::vec3(0.6f * mScale), meshManager.LoadMesh(Mona::Mesh::PrimitiveType::Sphere), bodyMaterial);
 
-	auto sphere3 = world.CreateGameObject<Mona::GameObject>();
-	world.AddComponent<Mona::TransformComponent>(sphere3, mInitPos + glm::vec3(0.0f, 3.5f * mScale, 0.0f), glm::fquat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(0.3f * mScale));
-	world.AddComponent<Mona::StaticMeshComponent>(sphere3, meshManager.LoadMesh(Mona::Mesh::PrimitiveType::Sphere), bodyMaterial);
+	addMeshPart(world, mInitPos + glm::vec3(0.0f, 3.5f * mScale, 0.0f), glm::vec3(0.3f * mScale), meshManager.LoadMesh(Mona::Mesh::PrimitiveType::Sphere), bodyMaterial);
 
-	auto nose = world.CreateGameObject<Mona::GameObject>();
-	world.AddComponent<Mona::TransformComponent>(nose, mInitPos + glm::vec3(0.0f, 3.5f * mScale, 0.3f*mScale), glm::fquat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(0.05f * mScale));
-	world.AddComponent<Mona::StaticMeshComponent>(nose, meshManager.LoadMesh(Mona::Mesh::PrimitiveType::Cube), noseMaterial);
+	addMeshPart(world, mInitPos + glm::vec3(0.0f, 3.5f * mScale, 0.3f*mScale), glm::vec3(0.05f * mScale), meshManager.LoadMesh(Mona::Mesh::PrimitiveType::Cube), noseMaterial);
+
+	mActivation->registerObject(this);
 }
 
-void Obstacle::UserUpdate(Mona::World& world, float timeStep) noexcept {
-	glm::vec3 playerPos = mPlayer->getPos();
-	bool inX = (mInitPos.x - 1.0f * mScale <= playerPos.x) && (playerPos.x <= mInitPos.x + 1.0f * mScale);
-	bool inZ = (mInitPos.z - 1.0f * mScale <= playerPos.z) && (playerPos.z <= mInitPos.z + 1.0f * mScale);
-	bool inY = (mInitPos.y <= playerPos.y) && (playerPos.y <= mInitPos.y + 3.8f * mScale);
-	if (inX && inY && inZ && mIsVisible) {
-		mPlayer->stopPlayer(world);
-		mIsVisible = false;
+int Obstacle::findContact(const std::vector<glm::vec3>& riderPositions) const {
+	if (!mIsVisible) return -1;
+	for (size_t i = 0; i < riderPositions.size(); i++) {
+		const glm::vec3& playerPos = riderPositions[i];
+		bool inX = (mInitPos.x - 1.0f * mScale <= playerPos.x) && (playerPos.x <= mInitPos.x + 1.0f * mScale);
+		bool inZ = (mInitPos.z - 1.0f * mScale <= playerPos.z) && (playerPos.z <= mInitPos.z + 1.0f * mScale);
+		bool inY = (mInitPos.y <= playerPos.y) && (playerPos.y <= mInitPos.y + 3.8f * mScale);
+		if (inX && inY && inZ) return static_cast<int>(i);
 	}
+	return -1;
+}
+
+void Obstacle::applyContact(Mona::World& world, Mona::GameObjectHandle<Player>& rider) {
+	// El primer rider que lo toca lo consume
+	rider->stopPlayer(world);
+	mIsVisible = false;
 }
\ No newline at end of file
@@ -1,12 +1,24 @@
 #include "player.h"
 #include <iostream>
 
-Player::Player(glm::vec3 initPos, MeshNavigator* meshNav, float timer) : mInitPos(initPos), m_MeshNav(meshNav), game_timer(timer) {}
+Player::Player(glm::vec3 initPos, MeshNavigator* meshNav, Mona::GameObjectHandle<VoiceManager> voices, float timer) : mInitPos(initPos), mPosition(initPos), game_timer(timer), m_MeshNav(meshNav), mVoices(voices) {}
 
 Player::~Player() = default;
 
-glm::vec3 Player::getPos() {
-	return mTransform->GetLocalTranslation();
+void Player::playSound(std::shared_ptr<Mona::AudioClip> clip, VoicePriority priority) {
+	if (mSilent) return;
+	if (mDeferSounds) {
+		mPendingSounds.push_back({ clip, mPosition, priority });
+		return;
+	}
+	mVoices->playClip3D(clip, mPosition, 0.3f, priority);
+}
+
+void Player::flushSounds() {
+	for (const PendingSound& sound : mPendingSounds) {
+		mVoices->playClip3D(sound.clip, sound.position, 0.3f, sound.priority);
+	}
+	mPendingSounds.clear();
 }
 
 void Player::stopPlayer(Mona::World& world) {
@@ -14,12 +26,42 @@ void Player::stopPlayer(Mona::World& world) {
 	stopped = true;
 	mStopTimer = 3.0f;
 	velocity = glm::vec3(0.0f);
-	world.PlayAudioClip3D(mCrashSound, mTransform->GetLocalTranslation(), 0.3f);
+	playSound(mCrashSound, VoicePriority::High);
 }
 
 void Player::accelleratePlayer(Mona::World& world) {
 	acceleration = mbuffAcceleration;
-	world.PlayAudioClip3D(mAccelerationSound, mTransform->GetLocalTranslation(), 0.3f);
+	playSound(mAccelerationSound, VoicePriority::Medium);
+}
+
+void Player::saveState(PlayerState& state) const {
+	state.position = mPosition;
+	state.velocity = velocity;
+	state.acceleration = acceleration;
+	state.reaccelerate = reaccelerate;
+	state.stopTimer = mStopTimer;
+	state.accTimer = mAccTimer;
+	state.gameTimer = mGameTimer;
+	state.flags = (onFloor ? PlayerState::OnFloor : 0) | (stopped ? PlayerState::Stopped : 0) |
+		(win ? PlayerState::Win : 0) | (loose ? PlayerState::Loose : 0);
+}
+
+void Player::restoreState(const PlayerState& state) {
+	mPosition = state.position;
+	velocity = state.velocity;
+	acceleration = state.acceleration;
+	reaccelerate = state.reaccelerate;
+	mStopTimer = state.stopTimer;
+	mAccTimer = state.accTimer;
+	mGameTimer = state.gameTimer;
+	onFloor = (state.flags & PlayerState::OnFloor) != 0;
+	stopped = (state.flags & PlayerState::Stopped) != 0;
+	win = (state.flags & PlayerState::Win) != 0;
+	loose = (state.flags & PlayerState::Loose) != 0;
+}
+
+void Player::syncTransform() {
+	mTransform->SetTranslation(mPosition);
 }
 
 void Player::UserStartUp(Mona::World& world) noexcept {
@@ -33,29 +75,65 @@ void Player::UserStartUp(Mona::World& world) noexcept {
 	auto& config = Mona::Config::GetInstance();
 	std::filesystem::path terrain_p = config.getPathOfApplicationAsset("Models/scnd_snow_terrain_quad.obj");
 
-	m_MeshNav->loadMeshToMap(terrain_p.string());
+	// Con varios riders el terreno se carga una sola vez
+	if (m_MeshNav->quads.empty()) m_MeshNav->loadMeshToMap(terrain_p.string());
 
 	auto& audioClipManager = Mona::AudioClipManager::GetInstance();
-	mAccelerationSound = audioClipManager.LoadAudioClip(config.getPathOfApplicationAsset("Sounds/SFX/accel.wav"));
-	mSlideSound = audioClipManager.LoadAudioClip(config.getPathOfApplicationAsset("Sounds/SFX/slide.wav"));
-	mCrashSound = audioClipManager.LoadAudioClip(config.getPathOfApplicationAsset("Sounds/SFX/crash.wav"));
-	mWinSound = audioClipManager.LoadAudioClip(config.getPathOfApplicationAsset("Sounds/APOGG/LifeIsFullOfJoy.wav"));
+	auto loadClip = [&](const std::string& asset) {
+		std::filesystem::path path = config.getPathOfApplicationAsset(asset);
+		MemoryTracker::GetInstance().trackAudioFile(path);
+		return audioClipManager.LoadAudioClip(path);
+	};
+	mAccelerationSound = loadClip("Sounds/SFX/accel.wav");
+	mSlideSound = loadClip("Sounds/SFX/slide.wav");
+	mCrashSound = loadClip("Sounds/SFX/crash.wav");
+	mWinSound = loadClip("Sounds/APOGG/LifeIsFullOfJoy.wav");
+
+	// Limites por clip para que los rebotes y boosts seguidos no acaparen el pool
+	mVoices->setClipLimit(mSlideSound, 2);
+	mVoices->setClipLimit(mAccelerationSound, 2);
+	mVoices->setClipLimit(mCrashSound, 1);
+	mVoices->setClipLimit(mWinSound, 1);
 
 
 }
 
 void Player::UserUpdate(Mona::World& world, float timeStep) noexcept {
+	if (!mDriven) {
+		simulate(readInput(world), timeStep);
+		syncTransform();
+	}
+	if (!loose) spdlog::info("Timer: {}", mGameTimer);
+}
+
+void Player::simulate(const PlayerInput& input, float timeStep) {
 	if (!loose) {
 		mGameTimer -= timeStep;
-		spdlog::info("Timer: {}", mGameTimer);
 		if (mGameTimer <= 0.0f) {
 			loose = true;
 		}
 
-		keyPressed(world, timeStep);
-		buttonPressed(world, timeStep);
+		if (onFloor && !stopped) {
+			if ((input.buttons & PlayerInput::Accelerate) && mAccTimer > 1.0f) {
+				acceleration = maxAcceleration;
+				velocity *= acceleration;
+				mAccTimer = 0.0f;
+				playSound(mAccelerationSound, VoicePriority::Medium);
+			}
+			if (input.buttons & PlayerInput::Brake) {
+				velocity *= deceleration;
+			}
+			if (input.steer != 0) {
+				velocity = glm::rotateY(velocity, (input.steer / 127.0f) * rotationSpeed * timeStep);
+			}
+		}
+		if (input.buttons & PlayerInput::Reset) {
+			mPosition = mInitPos;
+			velocity = glm::vec3(0.0f);
+		}
 	
-		Quad* q = m_MeshNav->getQuadAtPosition(mTransform->GetLocalTranslation().x, mTransform->GetLocalTranslation().z);
+		GroundSample ground;
+		bool hasGround = m_MeshNav->sampleGround(mPosition.x, mPosition.z, ground);
 		mAccTimer += timeStep;
 		acceleration = std::max(1.0f, acceleration - timeStep);
 
@@ -64,15 +142,15 @@ void Player::UserUpdate(Mona::World& world, float timeStep) noexcept {
 		if (mStopTimer <= 0.0f) {
 			stopped = false;
 		}
-		if (mTransform->GetLocalTranslation().z < -520.698f && !win) {
+		if (mPosition.z < finishLineZ && !win) {
 			win = true;
-			world.PlayAudioClip3D(mWinSound, mTransform->GetLocalTranslation(), 0.3f);
+			playSound(mWinSound, VoicePriority::Critical);
 		}
 
-		if (q != nullptr && !stopped && !win) {
+		if (hasGround && !stopped && !win) {
 			reaccelerate = std::min(1.0f, reaccelerate + timeStep);
 		
-			glm::vec3 quadNormal = q->calculateQuadNormal();
+			glm::vec3 quadNormal = ground.normal;
 
 		
 			glm::vec3 upVector = glm::vec3(0.0f, 1.0f, 0.0f);
@@ -90,15 +168,15 @@ void Player::UserUpdate(Mona::World& world, float timeStep) noexcept {
 			}
 
 		
-			float currentY = mTransform->GetLocalTranslation().y;
-			float groundY = q->getHeightAt(mTransform->GetLocalTranslation().x, mTransform->GetLocalTranslation().z);
+			float currentY = mPosition.y;
+			float groundY = ground.height;
 
 			if (currentY <= groundY + groundThreshold) {
 				velocity += slideForce * timeStep * slideSpeed * (angleDegrees / 45.0f) * (angleDegrees / 45.0f);
-				if (!onFloor) world.PlayAudioClip3D(mSlideSound, mTransform->GetLocalTranslation(), 0.3f);
+				if (!onFloor) playSound(mSlideSound, VoicePriority::Low);
 				onFloor = true;
 		
-				mTransform->SetTranslation(glm::vec3(mTransform->GetLocalTranslation().x, groundY, mTransform->GetLocalTranslation().z));
+				mPosition.y = groundY;
 				float angleIn = glm::dot(horizontalVelocity, quadNormal);
 				if (angleIn > 0.0f) {
 					velocity.y = angleIn*2.0f;
@@ -112,60 +190,33 @@ void Player::UserUpdate(Mona::World& world, float timeStep) noexcept {
 				velocity += gravity * 10.0f * timeStep;
 			}
 
-			mTransform->Translate(velocity * timeStep);
+			mPosition += velocity * timeStep;
 		}
 	}
 
 }
 
 
-void Player::keyPressed(Mona::World& world, float timeStep) {
+PlayerInput Player::readInput(Mona::World& world) const {
 	auto& input = world.GetInput();
-	
-	if (onFloor && !stopped) {
-		if ((input.IsKeyPressed(MONA_KEY_W) || input.IsKeyPressed(MONA_KEY_UP)) && mAccTimer > 1.0f) {
-			acceleration = maxAcceleration;
-			velocity *= acceleration ;
-			mAccTimer = 0.0f;
-			world.PlayAudioClip3D(mAccelerationSound, mTransform->GetLocalTranslation(), 0.3f);
-		}
-		if (input.IsKeyPressed(MONA_KEY_S) || input.IsKeyPressed(MONA_KEY_DOWN)) {
-			velocity *= deceleration ;
-		}
-		if (input.IsKeyPressed(MONA_KEY_D) || input.IsKeyPressed(MONA_KEY_RIGHT)) {
-			velocity = glm::rotateY(velocity, -rotationSpeed * timeStep);
-		}
-		if (input.IsKeyPressed(MONA_KEY_A) || input.IsKeyPressed(MONA_KEY_LEFT)) {
-			velocity = glm::rotateY(velocity, rotationSpeed * timeStep);
-		}
+	PlayerInput result;
 
+	if (input.IsKeyPressed(MONA_KEY_W) || input.IsKeyPressed(MONA_KEY_UP) || input.IsGamepadButtonPressed(MONA_JOYSTICK_1, MONA_GAMEPAD_BUTTON_CROSS)) {
+		result.buttons |= PlayerInput::Accelerate;
+	}
+	if (input.IsKeyPressed(MONA_KEY_S) || input.IsKeyPressed(MONA_KEY_DOWN) || input.IsGamepadButtonPressed(MONA_JOYSTICK_1, MONA_GAMEPAD_BUTTON_CIRCLE)) {
+		result.buttons |= PlayerInput::Brake;
 	}
 	if (input.IsKeyPressed(MONA_KEY_R)) {
-		mTransform->SetTranslation(mInitPos);
-		velocity = glm::vec3(0.0f);
+		result.buttons |= PlayerInput::Reset;
 	}
-	//if (moveDir.x != 0.0f || moveDir.y != 0.0f || moveDir.z != 0.0f) moveDir = glm::normalize(moveDir);
-	//mTransform->Translate(moveDir * timeStep * mSpeed);
 
-}
+	float steer = 0.0f;
+	if (input.IsKeyPressed(MONA_KEY_D) || input.IsKeyPressed(MONA_KEY_RIGHT)) steer -= 1.0f;
+	if (input.IsKeyPressed(MONA_KEY_A) || input.IsKeyPressed(MONA_KEY_LEFT)) steer += 1.0f;
+	float leftStickX = input.GetGamepadAxisValue(MONA_JOYSTICK_1, MONA_GAMEPAD_AXIS_LEFT_X);
+	if (std::abs(leftStickX) > 0.2f) steer += leftStickX;
+	result.steer = static_cast<int8_t>(std::round(std::clamp(steer, -1.0f, 1.0f) * 127.0f));
 
-void Player::buttonPressed(Mona::World& world, float timeStep) {
-	auto& input = world.GetInput();
-	if (onFloor) {
-		float leftStickX = input.GetGamepadAxisValue(MONA_JOYSTICK_1, MONA_GAMEPAD_AXIS_LEFT_X);
-
-		if (std::abs(leftStickX) > 0.2f) velocity = glm::rotateY(velocity, leftStickX * rotationSpeed * timeStep);
-
-		if (input.IsGamepadButtonPressed(MONA_JOYSTICK_1, MONA_GAMEPAD_BUTTON_CROSS) && mAccTimer > 1.0f) {
-			acceleration = maxAcceleration;
-			velocity *= acceleration;
-			mAccTimer = 0.0f;
-			world.PlayAudioClip3D(mAccelerationSound, mTransform->GetLocalTranslation(), 0.3f);
-		}
-		if (input.IsGamepadButtonPressed(MONA_JOYSTICK_1, MONA_GAMEPAD_BUTTON_CIRCLE)) {
-			velocity *= deceleration;
-		}
-
-	}
-	
-}
\ No newline at end of file
+	return result;
+}
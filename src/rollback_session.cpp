@@ -0,0 +1,206 @@
+#include "rollback_session.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <limits>
+
+using RollbackClock = std::chrono::steady_clock;
+
+static double microsSince(RollbackClock::time_point start) {
+	return std::chrono::duration<double, std::micro>(RollbackClock::now() - start).count();
+}
+
+RollbackCore::RollbackCore(RollbackGame* game, LoopbackPeer* outgoing, LoopbackPeer* incoming, float tickRate, int maxRollbackTicks) :
+	mGame(game), mOutgoing(outgoing), mIncoming(incoming),
+	mTickStep(1.0f / tickRate), mMaxRollbackTicks(std::clamp(maxRollbackTicks, 1, static_cast<int>(historySize / 2))),
+	mSnapshots(mMaxRollbackTicks + 1), mLocalInputs(historySize), mRemoteInputs(historySize),
+	mRemoteInputTick(historySize, std::numeric_limits<uint32_t>::max()), mRemoteUsed(historySize) {}
+
+void RollbackCore::advance(float timeStep) {
+	// Tope de ticks por frame para que un frame lento no termine en una espiral de re-simulación
+	const int maxTicksPerFrame = 4;
+
+	mClockMs += timeStep * 1000.0;
+	mAccumulator += timeStep;
+
+	uint32_t mispredicted = receiveRemoteInputs();
+	if (mispredicted < mTick) rollback(mispredicted);
+
+	int ticks = 0;
+	while (mAccumulator >= mTickStep && ticks < maxTicksPerFrame) {
+		if (mTick - mRemoteConfirmed >= static_cast<uint32_t>(mMaxRollbackTicks)) {
+			// Más allá de la ventana de rollback no hay snapshot al cual volver: se espera al remoto
+			// y se reenvían los inputs por si se perdió el último paquete
+			sendLocalInputs(mTick);
+			mStats.stalledFrames++;
+			break;
+		}
+		advanceTick();
+		mAccumulator -= mTickStep;
+		ticks++;
+	}
+	mAccumulator = std::min(mAccumulator, mTickStep);
+}
+
+void RollbackCore::saveSnapshot(GameSnapshot& snapshot, uint32_t tick) const {
+	mGame->saveState(snapshot);
+	snapshot.tick = tick;
+}
+
+void RollbackCore::advanceTick() {
+	mLocalInputs[mTick % historySize] = mGame->readLocalInput();
+	sendLocalInputs(mTick + 1);
+
+	auto start = RollbackClock::now();
+	saveSnapshot(mSnapshots[mTick % mSnapshots.size()], mTick);
+	mStats.saveMicros += microsSince(start);
+	mStats.saves++;
+
+	simulateTick(mTick);
+	mTick++;
+	mStats.ticks++;
+}
+
+void RollbackCore::simulateTick(uint32_t tick) {
+	uint32_t slot = tick % historySize;
+	PlayerInput remote = remoteInputFor(tick);
+	mRemoteUsed[slot] = remote;
+	mGame->simulateTick(mLocalInputs[slot], remote, mTickStep);
+}
+
+void RollbackCore::sendLocalInputs(uint32_t endTick) {
+	InputPacket packet;
+	packet.count = static_cast<uint8_t>(std::min<uint32_t>(endTick, InputPacket::maxInputs));
+	packet.firstTick = endTick - packet.count;
+	for (int i = 0; i < packet.count; i++) {
+		packet.inputs[i] = mLocalInputs[(packet.firstTick + i) % historySize];
+	}
+	mOutgoing->send(packet, mClockMs);
+}
+
+uint32_t RollbackCore::receiveRemoteInputs() {
+	mReceived.clear();
+	mIncoming->receive(mClockMs, mReceived);
+
+	uint32_t mispredicted = mTick;
+	for (const InputPacket& packet : mReceived) {
+		for (int i = 0; i < packet.count; i++) {
+			uint32_t tick = packet.firstTick + i;
+			// Ya confirmado, o tan adelantado que pisaría el último input confirmado en el historial
+			if (tick < mRemoteConfirmed || tick >= mRemoteConfirmed + historySize - 1) continue;
+			uint32_t slot = tick % historySize;
+			if (mRemoteInputTick[slot] == tick) continue;
+
+			mRemoteInputs[slot] = packet.inputs[i];
+			mRemoteInputTick[slot] = tick;
+			if (tick < mTick && packet.inputs[i] != mRemoteUsed[slot]) {
+				mispredicted = std::min(mispredicted, tick);
+			}
+		}
+	}
+	while (mRemoteInputTick[mRemoteConfirmed % historySize] == mRemoteConfirmed) mRemoteConfirmed++;
+	return mispredicted;
+}
+
+PlayerInput RollbackCore::remoteInputFor(uint32_t tick) const {
+	uint32_t slot = tick % historySize;
+	if (mRemoteInputTick[slot] == tick) return mRemoteInputs[slot];
+	// Predicción: el remoto sigue haciendo lo último que se le confirmó
+	if (mRemoteConfirmed == 0) return PlayerInput();
+	return mRemoteInputs[(mRemoteConfirmed - 1) % historySize];
+}
+
+void RollbackCore::rollback(uint32_t fromTick) {
+	if (mTick - fromTick >= mSnapshots.size()) {
+		// No debería pasar: advanceTick se detiene antes de salir de la ventana
+		std::cout << "RollbackSession: tick " << fromTick << " is outside the rollback window" << std::endl;
+		return;
+	}
+
+	auto start = RollbackClock::now();
+	mGame->restoreState(mSnapshots[fromTick % mSnapshots.size()]);
+	mStats.restoreMicros += microsSince(start);
+	mStats.restores++;
+
+	mGame->beginResimulation();
+	start = RollbackClock::now();
+	for (uint32_t tick = fromTick; tick < mTick; tick++) {
+		// El snapshot de fromTick sigue siendo válido; los siguientes cambian con el input corregido
+		if (tick != fromTick) saveSnapshot(mSnapshots[tick % mSnapshots.size()], tick);
+		simulateTick(tick);
+	}
+	mStats.resimMicros += microsSince(start);
+	mGame->endResimulation();
+
+	int depth = static_cast<int>(mTick - fromTick);
+	mStats.rollbacks++;
+	mStats.resimulatedTicks += depth;
+	mStats.maxRollbackTicks = std::max(mStats.maxRollbackTicks, depth);
+}
+
+RollbackSession::RollbackSession(Mona::GameObjectHandle<Player> localRider, Mona::GameObjectHandle<Player> remoteRider, Mona::GameObjectHandle<CourseActivation> activation,
+	LoopbackPeer* peer, float tickRate, int maxRollbackTicks) :
+	mLocalRider(localRider), mRemoteRider(remoteRider), mActivation(activation),
+	mCore(this, peer, peer, tickRate, maxRollbackTicks) {}
+
+RollbackSession::~RollbackSession() = default;
+
+void RollbackSession::UserStartUp(Mona::World& world) noexcept {
+	mLocalRider->setDriven(true);
+	mRemoteRider->setDriven(true);
+	// La ventana de despiertos y los triggers corren dentro de cada tick
+	mActivation->setScheduled(true);
+}
+
+void RollbackSession::UserUpdate(Mona::World& world, float timeStep) noexcept {
+	if (!mScheduled) advance(world, timeStep);
+}
+
+void RollbackSession::advance(Mona::World& world, float timeStep) {
+	mWorld = &world;
+	mCore.advance(timeStep);
+	mWorld = nullptr;
+
+	mLocalRider->syncTransform();
+	mRemoteRider->syncTransform();
+}
+
+PlayerInput RollbackSession::readLocalInput() {
+	return mLocalRider->readInput(*mWorld);
+}
+
+void RollbackSession::saveState(GameSnapshot& snapshot) const {
+	snapshot.consumedTriggers = mActivation->getConsumedMask();
+	mLocalRider->saveState(snapshot.riders[0]);
+	mRemoteRider->saveState(snapshot.riders[1]);
+}
+
+void RollbackSession::restoreState(const GameSnapshot& snapshot) {
+	mLocalRider->restoreState(snapshot.riders[0]);
+	mRemoteRider->restoreState(snapshot.riders[1]);
+	mActivation->restoreConsumed(snapshot.consumedTriggers);
+}
+
+void RollbackSession::simulateTick(const PlayerInput& local, const PlayerInput& remote, float timeStep) {
+	mLocalRider->simulate(local, timeStep);
+	mRemoteRider->simulate(remote, timeStep);
+	// La ventana no está en el snapshot: se rehace con las posiciones de este tick, así que al
+	// re-simular los triggers revisan los mismos objetos que la primera vez
+	mActivation->updateWindow(*mWorld);
+	mActivation->updateTriggers(*mWorld);
+}
+
+void RollbackSession::beginResimulation() {
+	// Lo que se re-simula ya se escuchó y se dibujó la primera vez
+	mLocalRider->setSilent(true);
+	mRemoteRider->setSilent(true);
+	mActivation->setVisibilityDeferred(true);
+}
+
+void RollbackSession::endResimulation() {
+	// Ya en el tick actual: solo ahora se agregan o quitan los meshes de lo que cambió
+	mActivation->setVisibilityDeferred(false);
+	mActivation->applyVisibility(*mWorld);
+	mLocalRider->setSilent(false);
+	mRemoteRider->setSilent(false);
+}
@@ -0,0 +1,142 @@
+#include "snow_deformation.h"
+#include <algorithm>
+#include <cmath>
+
+// División entera que redondea hacia abajo también con negativos
+static int floorDiv(int value, int divisor) {
+    return value >= 0 ? value / divisor : (value - divisor + 1) / divisor;
+}
+
+SnowDeformation::SnowDeformation(float cellSize, float maxDepth) :
+    m_cellSize(cellSize), m_invCellSize(1.0f / cellSize), m_maxDepth(maxDepth) {}
+
+const SnowDeformation::Tile* SnowDeformation::findTile(int tileX, int tileZ) const {
+    auto it = m_tiles.find(tileKey(tileX, tileZ));
+    return it == m_tiles.end() ? nullptr : it->second.get();
+}
+
+SnowDeformation::Tile& SnowDeformation::getOrCreateTile(int tileX, int tileZ) {
+    auto& tile = m_tiles[tileKey(tileX, tileZ)];
+    if (!tile) tile = std::make_unique<Tile>();
+    return *tile;
+}
+
+float SnowDeformation::nodeDelta(int cellX, int cellZ) const {
+    int tileX = floorDiv(cellX, tileCells);
+    int tileZ = floorDiv(cellZ, tileCells);
+    const Tile* tile = findTile(tileX, tileZ);
+    if (tile == nullptr) return 0.0f;
+    return tile->delta[(cellZ - tileZ * tileCells) * tileCells + (cellX - tileX * tileCells)];
+}
+
+float SnowDeformation::getHeightDelta(float x, float z) const {
+    if (m_tiles.empty()) return 0.0f;
+
+    float fx = x * m_invCellSize;
+    float fz = z * m_invCellSize;
+    int cx = static_cast<int>(std::floor(fx));
+    int cz = static_cast<int>(std::floor(fz));
+    float tx = fx - cx;
+    float tz = fz - cz;
+
+    float d00, d10, d01, d11;
+    int tileX = floorDiv(cx, tileCells);
+    int tileZ = floorDiv(cz, tileCells);
+    int localX = cx - tileX * tileCells;
+    int localZ = cz - tileZ * tileCells;
+    if (localX < tileCells - 1 && localZ < tileCells - 1) {
+        // Caso común: las cuatro celdas están en el mismo tile y basta una búsqueda
+        const Tile* tile = findTile(tileX, tileZ);
+        if (tile == nullptr) return 0.0f;
+        const float* row = &tile->delta[localZ * tileCells + localX];
+        d00 = row[0];
+        d10 = row[1];
+        d01 = row[tileCells];
+        d11 = row[tileCells + 1];
+    }
+    else {
+        d00 = nodeDelta(cx, cz);
+        d10 = nodeDelta(cx + 1, cz);
+        d01 = nodeDelta(cx, cz + 1);
+        d11 = nodeDelta(cx + 1, cz + 1);
+    }
+
+    float top = d00 + (d10 - d00) * tx;
+    float bottom = d01 + (d11 - d01) * tx;
+    return top + (bottom - top) * tz;
+}
+
+void SnowDeformation::stamp(float x, float z, float radius, float depth) {
+    if (radius <= 0.0f || depth <= 0.0f) return;
+
+    int minX = static_cast<int>(std::floor((x - radius) * m_invCellSize));
+    int maxX = static_cast<int>(std::ceil((x + radius) * m_invCellSize));
+    int minZ = static_cast<int>(std::floor((z - radius) * m_invCellSize));
+    int maxZ = static_cast<int>(std::ceil((z + radius) * m_invCellSize));
+    float invRadius2 = 1.0f / (radius * radius);
+    depth = std::min(depth, m_maxDepth);
+
+    // Se recorre tile por tile para buscar cada uno una sola vez
+    for (int tileZ = floorDiv(minZ, tileCells); tileZ <= floorDiv(maxZ, tileCells); tileZ++) {
+        for (int tileX = floorDiv(minX, tileCells); tileX <= floorDiv(maxX, tileCells); tileX++) {
+            int x0 = std::max(minX, tileX * tileCells) - tileX * tileCells;
+            int x1 = std::min(maxX, tileX * tileCells + tileCells - 1) - tileX * tileCells;
+            int z0 = std::max(minZ, tileZ * tileCells) - tileZ * tileCells;
+            int z1 = std::min(maxZ, tileZ * tileCells + tileCells - 1) - tileZ * tileCells;
+
+            Tile* tile = nullptr;
+            for (int lz = z0; lz <= z1; lz++) {
+                float dz = (tileZ * tileCells + lz) * m_cellSize - z;
+                for (int lx = x0; lx <= x1; lx++) {
+                    float dx = (tileX * tileCells + lx) * m_cellSize - x;
+                    float t = (dx * dx + dz * dz) * invRadius2;
+                    if (t >= 1.0f) continue;
+
+                    // Perfil suave (1 - t)^2: más hondo al centro y sin escalón en el borde
+                    float target = -depth * (1.0f - t) * (1.0f - t);
+                    if (tile == nullptr) {
+                        const Tile* existing = findTile(tileX, tileZ);
+                        // No se crea un tile solo para escribir algo que no lo hunde más
+                        if (existing != nullptr && existing->delta[lz * tileCells + lx] <= target) continue;
+                        tile = &getOrCreateTile(tileX, tileZ);
+                    }
+
+                    float& delta = tile->delta[lz * tileCells + lx];
+                    if (delta <= target) continue;
+                    delta = target;
+
+                    if (tile->dirtyMaxX < 0) m_dirtyTiles.push_back(tileKey(tileX, tileZ));
+                    tile->dirtyMinX = std::min(tile->dirtyMinX, lx);
+                    tile->dirtyMaxX = std::max(tile->dirtyMaxX, lx);
+                    tile->dirtyMinZ = std::min(tile->dirtyMinZ, lz);
+                    tile->dirtyMaxZ = std::max(tile->dirtyMaxZ, lz);
+                }
+            }
+        }
+    }
+}
+
+void SnowDeformation::collectDirtyRects(std::vector<DirtyRect>& out) {
+    for (uint64_t key : m_dirtyTiles) {
+        Tile& tile = *m_tiles[key];
+        DirtyRect rect;
+        rect.tileX = static_cast<int>(static_cast<int32_t>(key >> 32));
+        rect.tileZ = static_cast<int>(static_cast<int32_t>(key & 0xFFFFFFFFu));
+        rect.minX = tile.dirtyMinX;
+        rect.minZ = tile.dirtyMinZ;
+        rect.maxX = tile.dirtyMaxX;
+        rect.maxZ = tile.dirtyMaxZ;
+        out.push_back(rect);
+
+        tile.dirtyMinX = tileCells;
+        tile.dirtyMinZ = tileCells;
+        tile.dirtyMaxX = -1;
+        tile.dirtyMaxZ = -1;
+    }
+    m_dirtyTiles.clear();
+}
+
+const float* SnowDeformation::getTileData(int tileX, int tileZ) const {
+    const Tile* tile = findTile(tileX, tileZ);
+    return tile == nullptr ? nullptr : tile->delta;
+}
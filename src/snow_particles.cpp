@@ -0,0 +1,134 @@
+#include "snow_particles.h"
+#include "thread_pool.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SNOW_PARTICLES_SSE 1
+#endif
+
+SnowParticleSystem::SnowParticleSystem(size_t capacity) : m_capacity(capacity) {
+    // Se redondea a múltiplo de 4 para que los lotes SIMD nunca lean fuera de los arreglos
+    size_t padded = (capacity + 3) & ~size_t(3);
+    for (auto* pool : { &m_posX, &m_posY, &m_posZ, &m_velX, &m_velY, &m_velZ, &m_life, &m_maxLife, &m_ground }) {
+        pool->assign(padded, 0.0f);
+    }
+    m_quad.assign(padded, nullptr);
+}
+
+float SnowParticleSystem::random01() {
+    // xorshift32: barato y suficiente para dispersar la nieve
+    m_rngState ^= m_rngState << 13;
+    m_rngState ^= m_rngState >> 17;
+    m_rngState ^= m_rngState << 5;
+    return (m_rngState >> 8) * (1.0f / 16777216.0f);
+}
+
+void SnowParticleSystem::emit(const glm::vec3& origin, const glm::vec3& baseVelocity, float spread, int count, float lifetime) {
+    for (int i = 0; i < count && m_count < m_capacity; i++) {
+        size_t p = m_count++;
+        m_posX[p] = origin.x;
+        m_posY[p] = origin.y;
+        m_posZ[p] = origin.z;
+        m_velX[p] = baseVelocity.x + (random01() * 2.0f - 1.0f) * spread;
+        m_velY[p] = baseVelocity.y + random01() * spread;
+        m_velZ[p] = baseVelocity.z + (random01() * 2.0f - 1.0f) * spread;
+        m_life[p] = lifetime * (0.5f + 0.5f * random01());
+        m_maxLife[p] = m_life[p];
+        m_quad[p] = nullptr;
+    }
+}
+
+void SnowParticleSystem::integrate(size_t begin, size_t end, float timeStep) {
+    float dragFactor = std::max(0.0f, 1.0f - drag * timeStep);
+    size_t i = begin;
+#if defined(SNOW_PARTICLES_SSE)
+    const __m128 dt = _mm_set1_ps(timeStep);
+    const __m128 dv = _mm_set1_ps(gravity * timeStep);
+    const __m128 damp = _mm_set1_ps(dragFactor);
+    for (; i + 4 <= end; i += 4) {
+        __m128 vx = _mm_mul_ps(_mm_loadu_ps(&m_velX[i]), damp);
+        __m128 vy = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&m_velY[i]), dv), damp);
+        __m128 vz = _mm_mul_ps(_mm_loadu_ps(&m_velZ[i]), damp);
+        _mm_storeu_ps(&m_velX[i], vx);
+        _mm_storeu_ps(&m_velY[i], vy);
+        _mm_storeu_ps(&m_velZ[i], vz);
+        _mm_storeu_ps(&m_posX[i], _mm_add_ps(_mm_loadu_ps(&m_posX[i]), _mm_mul_ps(vx, dt)));
+        _mm_storeu_ps(&m_posY[i], _mm_add_ps(_mm_loadu_ps(&m_posY[i]), _mm_mul_ps(vy, dt)));
+        _mm_storeu_ps(&m_posZ[i], _mm_add_ps(_mm_loadu_ps(&m_posZ[i]), _mm_mul_ps(vz, dt)));
+        _mm_storeu_ps(&m_life[i], _mm_sub_ps(_mm_loadu_ps(&m_life[i]), dt));
+    }
+#endif
+    for (; i < end; i++) {
+        m_velX[i] *= dragFactor;
+        m_velY[i] = (m_velY[i] + gravity * timeStep) * dragFactor;
+        m_velZ[i] *= dragFactor;
+        m_posX[i] += m_velX[i] * timeStep;
+        m_posY[i] += m_velY[i] * timeStep;
+        m_posZ[i] += m_velZ[i] * timeStep;
+        m_life[i] -= timeStep;
+    }
+}
+
+void SnowParticleSystem::collide(size_t begin, size_t end) {
+    size_t i = begin;
+#if defined(SNOW_PARTICLES_SSE)
+    const __m128 bounce = _mm_set1_ps(-restitution);
+    const __m128 friction = _mm_set1_ps(groundFriction);
+    for (; i + 4 <= end; i += 4) {
+        __m128 y = _mm_loadu_ps(&m_posY[i]);
+        __m128 ground = _mm_loadu_ps(&m_ground[i]);
+        // La comparación con NaN da falso, así que las partículas fuera del terreno siguen cayendo
+        __m128 below = _mm_cmplt_ps(y, ground);
+
+        __m128 vx = _mm_loadu_ps(&m_velX[i]);
+        __m128 vy = _mm_loadu_ps(&m_velY[i]);
+        __m128 vz = _mm_loadu_ps(&m_velZ[i]);
+        _mm_storeu_ps(&m_posY[i], _mm_or_ps(_mm_and_ps(below, ground), _mm_andnot_ps(below, y)));
+        _mm_storeu_ps(&m_velY[i], _mm_or_ps(_mm_and_ps(below, _mm_mul_ps(vy, bounce)), _mm_andnot_ps(below, vy)));
+        _mm_storeu_ps(&m_velX[i], _mm_or_ps(_mm_and_ps(below, _mm_mul_ps(vx, friction)), _mm_andnot_ps(below, vx)));
+        _mm_storeu_ps(&m_velZ[i], _mm_or_ps(_mm_and_ps(below, _mm_mul_ps(vz, friction)), _mm_andnot_ps(below, vz)));
+    }
+#endif
+    for (; i < end; i++) {
+        if (m_posY[i] < m_ground[i]) {
+            m_posY[i] = m_ground[i];
+            m_velY[i] *= -restitution;
+            m_velX[i] *= groundFriction;
+            m_velZ[i] *= groundFriction;
+        }
+    }
+}
+
+void SnowParticleSystem::removeDead() {
+    // Se reemplaza cada partícula muerta por la última viva; el orden no importa
+    size_t i = 0;
+    while (i < m_count) {
+        if (m_life[i] > 0.0f) {
+            i++;
+            continue;
+        }
+        size_t last = --m_count;
+        m_posX[i] = m_posX[last];
+        m_posY[i] = m_posY[last];
+        m_posZ[i] = m_posZ[last];
+        m_velX[i] = m_velX[last];
+        m_velY[i] = m_velY[last];
+        m_velZ[i] = m_velZ[last];
+        m_life[i] = m_life[last];
+        m_maxLife[i] = m_maxLife[last];
+        m_quad[i] = m_quad[last];
+    }
+}
+
+void SnowParticleSystem::update(float timeStep, MeshNavigator& meshNav) {
+    if (m_count == 0) return;
+
+    // Cada rango hace las tres etapas seguidas para aprovechar que sus datos ya están en caché
+    ThreadPool::GetInstance().parallelFor(m_count, parallelGrain, [&](size_t begin, size_t end) {
+        integrate(begin, end, timeStep);
+        meshNav.sampleHeights(&m_posX[begin], &m_posZ[begin], &m_ground[begin], &m_quad[begin], end - begin);
+        collide(begin, end);
+    });
+
+    removeDead();
+}
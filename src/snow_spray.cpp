@@ -0,0 +1,91 @@
+#include "snow_spray.h"
+
+SnowSpray::SnowSpray(Mona::GameObjectHandle<Player> player, MeshNavigator* meshNav, size_t capacity, int visibleParticles) :
+	mPlayer(player), m_MeshNav(meshNav), mParticles(capacity), mVisibleParticles(visibleParticles) {}
+
+SnowSpray::~SnowSpray() = default;
+
+void SnowSpray::UserStartUp(Mona::World& world) noexcept {
+	auto& meshManager = Mona::MeshManager::GetInstance();
+	auto snowMaterial = std::static_pointer_cast<Mona::DiffuseFlatMaterial>(world.CreateMaterial(Mona::MaterialType::DiffuseFlat));
+	snowMaterial->SetDiffuseColor(glm::vec3(0.95f, 0.97f, 1.0f));
+	mProxyMesh = meshManager.LoadMesh(Mona::Mesh::PrimitiveType::Cube);
+	mProxyMaterial = snowMaterial;
+
+	// Los cubos se crean una vez sin mesh; updateProxies se los pone solo mientras muestran una partícula
+	mProxies.resize(mVisibleParticles);
+	for (auto& proxy : mProxies) {
+		proxy.object = world.CreateGameObject<Mona::GameObject>();
+		proxy.transform = world.AddComponent<Mona::TransformComponent>(proxy.object);
+	}
+}
+
+void SnowSpray::UserUpdate(Mona::World& world, float timeStep) noexcept {
+	if (!mScheduled) updateSpray(world, timeStep);
+}
+
+void SnowSpray::updateSpray(Mona::World& world, float timeStep) {
+	emitFromPlayer(timeStep);
+	mParticles.update(timeStep, *m_MeshNav);
+	updateProxies(world);
+}
+
+void SnowSpray::emitFromPlayer(float timeStep) {
+	bool onFloor = mPlayer->isOnFloor();
+	glm::vec3 position = mPlayer->getPos();
+	glm::vec3 velocity = mPlayer->getVelocity();
+	glm::vec3 horizontalVelocity = glm::vec3(velocity.x, 0.0f, velocity.z);
+	float speed = glm::length(horizontalVelocity);
+
+	// Aterrizaje: una explosión de polvo proporcional a la velocidad
+	if (onFloor && !mWasOnFloor) {
+		int count = static_cast<int>(landingBurst * std::min(1.0f, speed / 30.0f)) + landingBurst / 4;
+		mParticles.emit(position, glm::vec3(0.0f, 2.0f, 0.0f), 3.0f + speed * 0.1f, count, particleLifetime);
+	}
+	mWasOnFloor = onFloor;
+
+	// Al deslizar, la nieve sale hacia atrás del rider y crece con la velocidad
+	if (onFloor && speed > carveMinSpeed) {
+		mEmitAccumulator += carveRate * speed * timeStep;
+		int count = static_cast<int>(mEmitAccumulator);
+		mEmitAccumulator -= count;
+		glm::vec3 sprayVelocity = -0.3f * horizontalVelocity + glm::vec3(0.0f, 1.5f + speed * 0.05f, 0.0f);
+		mParticles.emit(position, sprayVelocity, 1.0f + speed * 0.05f, count, particleLifetime);
+	}
+	else {
+		mEmitAccumulator = 0.0f;
+	}
+}
+
+void SnowSpray::updateProxies(Mona::World& world) {
+	size_t count = mParticles.getCount();
+	size_t stride = std::max<size_t>(1, count / std::max(1, mVisibleParticles));
+	const float* x = mParticles.getPositionX();
+	const float* y = mParticles.getPositionY();
+	const float* z = mParticles.getPositionZ();
+	const float* life = mParticles.getLife();
+	const float* maxLife = mParticles.getMaxLife();
+
+	for (size_t i = 0; i < mProxies.size(); i++) {
+		size_t p = i * stride;
+		setProxyShown(world, i, p < count);
+		if (p < count) {
+			float size = proxySize * (0.3f + 0.7f * life[p] / maxLife[p]);
+			mProxies[i].transform->SetTranslation(glm::vec3(x[p], y[p], z[p]));
+			mProxies[i].transform->SetScale(glm::vec3(size));
+		}
+	}
+}
+
+void SnowSpray::setProxyShown(Mona::World& world, size_t index, bool shown) {
+	Proxy& proxy = mProxies[index];
+	if (proxy.shown == shown) return;
+	proxy.shown = shown;
+	// Igual que CourseObject::setRendered: el transform se queda y solo el mesh entra o sale de la lista de dibujo
+	if (shown) {
+		proxy.meshComponent = world.AddComponent<Mona::StaticMeshComponent>(proxy.object, mProxyMesh, mProxyMaterial);
+	}
+	else {
+		world.RemoveComponent(proxy.meshComponent);
+	}
+}
@@ -0,0 +1,111 @@
+#include "snow_trail_decals.h"
+#include <algorithm>
+#include <cmath>
+
+SnowTrailDecals::SnowTrailDecals(MeshNavigator* meshNav, float cellSize, int maxDecals, float decalSize) :
+	m_MeshNav(meshNav), mCellSize(cellSize), mMaxDecals(maxDecals), mDecalSize(decalSize) {}
+
+SnowTrailDecals::~SnowTrailDecals() = default;
+
+void SnowTrailDecals::UserStartUp(Mona::World& world) noexcept {
+	auto& meshManager = Mona::MeshManager::GetInstance();
+	auto trailMaterial = std::static_pointer_cast<Mona::DiffuseFlatMaterial>(world.CreateMaterial(Mona::MaterialType::DiffuseFlat));
+	trailMaterial->SetDiffuseColor(glm::vec3(0.74f, 0.79f, 0.88f));
+	mDecalMesh = meshManager.LoadMesh(Mona::Mesh::PrimitiveType::Cube);
+	mDecalMaterial = trailMaterial;
+
+	// Igual que el spray: las placas se crean una vez sin mesh y lo reciben cuando se usan
+	mDecals.resize(mMaxDecals);
+	mSlotKey.assign(mMaxDecals, 0);
+	mDecalOf.reserve(mMaxDecals);
+	for (auto& decal : mDecals) {
+		decal.object = world.CreateGameObject<Mona::GameObject>();
+		decal.transform = world.AddComponent<Mona::TransformComponent>(decal.object);
+	}
+}
+
+void SnowTrailDecals::UserUpdate(Mona::World& world, float timeStep) noexcept {
+	for (int slot : mChanged) {
+		Decal& decal = mDecals[slot];
+		if (decal.wantShown == decal.shown) continue;
+		decal.shown = decal.wantShown;
+		if (decal.shown) {
+			decal.meshComponent = world.AddComponent<Mona::StaticMeshComponent>(decal.object, mDecalMesh, mDecalMaterial);
+		}
+		else {
+			world.RemoveComponent(decal.meshComponent);
+		}
+	}
+	mChanged.clear();
+}
+
+void SnowTrailDecals::setShown(int slot, bool shown) {
+	Decal& decal = mDecals[slot];
+	if (decal.wantShown == shown) return;
+	decal.wantShown = shown;
+	mChanged.push_back(slot);
+}
+
+void SnowTrailDecals::upload(const DirtyRect& rect, const float* tileData) {
+	if (tileData == nullptr || mDecals.empty()) return;
+
+	// Celdas de placa que tienen alguna celda del rectángulo hundida
+	mTouched.clear();
+	float invDecalSize = 1.0f / mDecalSize;
+	int baseX = rect.tileX * SnowDeformation::tileCells;
+	int baseZ = rect.tileZ * SnowDeformation::tileCells;
+	for (int lz = rect.minZ; lz <= rect.maxZ; lz++) {
+		for (int lx = rect.minX; lx <= rect.maxX; lx++) {
+			if (tileData[lz * SnowDeformation::tileCells + lx] > -minDepth) continue;
+			int x = static_cast<int>(std::floor((baseX + lx) * mCellSize * invDecalSize));
+			int z = static_cast<int>(std::floor((baseZ + lz) * mCellSize * invDecalSize));
+			mTouched.push_back(decalKey(x, z));
+		}
+	}
+	std::sort(mTouched.begin(), mTouched.end());
+	mTouched.erase(std::unique(mTouched.begin(), mTouched.end()), mTouched.end());
+
+	for (uint64_t key : mTouched) {
+		int x = static_cast<int>(static_cast<int32_t>(key >> 32));
+		int z = static_cast<int>(static_cast<int32_t>(key & 0xFFFFFFFFu));
+		auto it = mDecalOf.find(key);
+		if (it != mDecalOf.end()) {
+			// Ya tiene placa: el surco se hundió más y la placa baja con él
+			place(it->second, x, z);
+			continue;
+		}
+
+		int slot = mNextSlot;
+		mNextSlot = (mNextSlot + 1) % mMaxDecals;
+		// La placa más antigua deja su celda
+		auto previous = mDecalOf.find(mSlotKey[slot]);
+		if (previous != mDecalOf.end() && previous->second == slot) mDecalOf.erase(previous);
+		mSlotKey[slot] = key;
+		mDecalOf[key] = slot;
+		place(slot, x, z);
+	}
+}
+
+void SnowTrailDecals::place(int slot, int x, int z) {
+	float centerX = (x + 0.5f) * mDecalSize;
+	float centerZ = (z + 0.5f) * mDecalSize;
+	GroundSample ground;
+	if (!m_MeshNav->sampleGround(centerX, centerZ, ground)) {
+		setShown(slot, false);
+		return;
+	}
+
+	// La placa se inclina con el suelo para no quedar enterrada a medias en las pendientes
+	glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f);
+	glm::vec3 normal = glm::normalize(ground.normal);
+	glm::vec3 axis = glm::cross(up, normal);
+	glm::fquat rotation = glm::fquat(1.0f, 0.0f, 0.0f, 0.0f);
+	if (glm::length(axis) > 1e-4f) {
+		rotation = glm::angleAxis(std::acos(std::clamp(normal.y, -1.0f, 1.0f)), glm::normalize(axis));
+	}
+
+	mDecals[slot].transform->SetTranslation(glm::vec3(centerX, ground.height, centerZ) + normal * decalLift);
+	mDecals[slot].transform->SetRotation(rotation);
+	mDecals[slot].transform->SetScale(glm::vec3(mDecalSize * 0.5f, decalThickness, mDecalSize * 0.5f));
+	setShown(slot, true);
+}
@@ -0,0 +1,46 @@
+#include "snow_trails.h"
+#include <algorithm>
+#include <iostream>
+
+TrailStamper::TrailStamper(SnowDeformation* deformation, float radius, float depth) :
+	mDeformation(deformation), mRadius(radius), mDepth(std::min(depth, maxDepth)) {
+	if (depth > maxDepth) {
+		std::cout << "SnowTrails: depth " << depth << " would lift riders off the ground, using " << maxDepth << std::endl;
+	}
+}
+
+void TrailStamper::advance(const glm::vec3& pos, bool onFloor) {
+	if (onFloor) {
+		// A alta velocidad el rider avanza más que un radio por frame: se estampa a lo largo del tramo
+		glm::vec3 from = mWasOnFloor ? mLastPos : pos;
+		float distance = glm::length(glm::vec3(pos.x - from.x, 0.0f, pos.z - from.z));
+		int steps = std::max(1, static_cast<int>(std::ceil(distance / (mRadius * 0.5f))));
+		for (int i = 1; i <= steps; i++) {
+			glm::vec3 p = glm::mix(from, pos, static_cast<float>(i) / steps);
+			mDeformation->stamp(p.x, p.z, mRadius, mDepth);
+		}
+	}
+	mLastPos = pos;
+	mWasOnFloor = onFloor;
+
+	mDirtyRects.clear();
+	mDeformation->collectDirtyRects(mDirtyRects);
+	if (mUpload) {
+		for (const DirtyRect& rect : mDirtyRects) {
+			mUpload(rect, mDeformation->getTileData(rect.tileX, rect.tileZ));
+		}
+	}
+}
+
+SnowTrails::SnowTrails(Mona::GameObjectHandle<Player> player, SnowDeformation* deformation, float radius, float depth) :
+	mPlayer(player), mStamper(deformation, radius, depth) {}
+
+SnowTrails::~SnowTrails() = default;
+
+void SnowTrails::UserUpdate(Mona::World& world, float timeStep) noexcept {
+	if (!mScheduled) updateTrails();
+}
+
+void SnowTrails::updateTrails() {
+	mStamper.advance(mPlayer->getPos(), mPlayer->isOnFloor());
+}
@@ -0,0 +1,136 @@
+#include "thread_pool.h"
+#include <algorithm>
+
+ThreadPool& ThreadPool::GetInstance() {
+    static ThreadPool instance(std::max(1u, std::thread::hardware_concurrency()) - 1);
+    return instance;
+}
+
+ThreadPool::ThreadPool(unsigned int threadCount) : m_ranges(new ChunkRange[threadCount + 1]) {
+    for (unsigned int i = 0; i < threadCount; i++) {
+        m_workers.emplace_back(&ThreadPool::workerLoop, this, static_cast<int>(i) + 1);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (auto& worker : m_workers) {
+        worker.join();
+    }
+}
+
+static uint64_t packRange(uint32_t front, uint32_t back) {
+    return (static_cast<uint64_t>(front) << 32) | back;
+}
+
+bool ThreadPool::popChunk(int slot, uint32_t& chunk) {
+    std::atomic<uint64_t>& bounds = m_ranges[slot].bounds;
+    uint64_t current = bounds.load(std::memory_order_acquire);
+    while (true) {
+        uint32_t front = static_cast<uint32_t>(current >> 32);
+        uint32_t back = static_cast<uint32_t>(current);
+        if (front >= back) return false;
+        if (bounds.compare_exchange_weak(current, packRange(front + 1, back), std::memory_order_acq_rel, std::memory_order_acquire)) {
+            chunk = front;
+            return true;
+        }
+    }
+}
+
+bool ThreadPool::stealChunks(int slot) {
+    int participants = getWorkerCount();
+    for (int offset = 1; offset < participants; offset++) {
+        int victim = (slot + offset) % participants;
+        std::atomic<uint64_t>& bounds = m_ranges[victim].bounds;
+        uint64_t current = bounds.load(std::memory_order_acquire);
+        while (true) {
+            uint32_t front = static_cast<uint32_t>(current >> 32);
+            uint32_t back = static_cast<uint32_t>(current);
+            if (front >= back) break;
+
+            // Se lleva la mitad del final, que es lo que el dueño va a tocar más tarde
+            uint32_t split = back - (back - front + 1) / 2;
+            if (bounds.compare_exchange_weak(current, packRange(front, split), std::memory_order_acq_rel, std::memory_order_acquire)) {
+                // El rango propio está vacío y solo su dueño lo rellena, así que basta un store
+                m_ranges[slot].bounds.store(packRange(split, back), std::memory_order_release);
+                m_steals.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void ThreadPool::runChunks(int slot, const std::function<void(size_t, size_t)>& job) {
+    uint32_t chunk;
+    do {
+        while (popChunk(slot, chunk)) {
+            size_t begin = chunk * m_grain;
+            job(begin, std::min(begin + m_grain, m_count));
+        }
+        // Si nadie tiene rangos pendientes, lo que falta ya lo están corriendo otros hilos
+    } while (stealChunks(slot));
+}
+
+void ThreadPool::workerLoop(int slot) {
+    uint64_t seenGeneration = 0;
+    const std::function<void(size_t, size_t)>* job = nullptr;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&] { return m_stop || (m_generation != seenGeneration && m_job != nullptr); });
+            if (m_stop) return;
+            seenGeneration = m_generation;
+            job = m_job;
+            m_active++;
+        }
+
+        // Se usa la copia: el que llama limpia m_job apenas termina su parte, aunque otros sigan trabajando
+        runChunks(slot, *job);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_active--;
+        }
+        m_done.notify_one();
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& fn) {
+    grain = std::max<size_t>(1, grain);
+    // Con poco trabajo no vale la pena despertar a nadie
+    if (count <= grain || m_workers.empty()) {
+        if (count > 0) fn(0, count);
+        return;
+    }
+
+    // Los índices de rango son de 32 bits
+    grain = std::max<size_t>(grain, (count - 1) / UINT32_MAX + 1);
+    size_t chunks = (count + grain - 1) / grain;
+
+    std::lock_guard<std::mutex> call(m_callMutex);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_job = &fn;
+        m_count = count;
+        m_grain = grain;
+        // Cada hilo parte con una parte contigua, así los rangos vecinos tienden a quedar en el mismo hilo
+        size_t participants = getWorkerCount();
+        for (size_t i = 0; i < participants; i++) {
+            m_ranges[i].bounds.store(packRange(static_cast<uint32_t>(chunks * i / participants), static_cast<uint32_t>(chunks * (i + 1) / participants)), std::memory_order_relaxed);
+        }
+        m_generation++;
+    }
+    m_wake.notify_all();
+
+    runChunks(0, fn);
+
+    // Se cierra el trabajo para que nadie más se sume y se espera a los que ya estaban dentro
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_job = nullptr;
+    m_done.wait(lock, [this] { return m_active == 0; });
+}
@@ -0,0 +1,120 @@
+#include "voice_manager.h"
+#include <algorithm>
+
+VoiceManager::VoiceManager(int poolSize, float cullThreshold, float referenceDistance) :
+	mPoolSize(poolSize), mCullThreshold(cullThreshold), mReferenceDistance(referenceDistance) {}
+
+VoiceManager::~VoiceManager() = default;
+
+void VoiceManager::UserStartUp(Mona::World& world) noexcept {
+	// Las fuentes se crean una sola vez; después solo se reciclan
+	mVoices.resize(mPoolSize);
+	for (auto& voice : mVoices) {
+		voice.object = world.CreateGameObject<Mona::GameObject>();
+		voice.transform = world.AddComponent<Mona::TransformComponent>(voice.object, glm::vec3(0.0f));
+		voice.source = world.AddComponent<Mona::AudioSourceComponent>(voice.object);
+		voice.source->SetIsLooping(false);
+	}
+}
+
+void VoiceManager::UserUpdate(Mona::World& world, float timeStep) noexcept {
+	if (!mScheduled) updateVoices(timeStep);
+}
+
+void VoiceManager::updateVoices(float timeStep) {
+	for (auto& voice : mVoices) {
+		if (!voice.active) continue;
+
+		voice.remaining -= timeStep;
+		if (voice.remaining <= 0.0f) {
+			voice.active = false;
+			voice.clip = nullptr;
+			continue;
+		}
+		// El listener se mueve con la cámara, así que la audibilidad cambia cada frame
+		voice.audibility = computeAudibility(voice.position, voice.volume);
+	}
+}
+
+void VoiceManager::setListenerTransform(Mona::TransformHandle listener) {
+	mListener = listener;
+	mHasListener = true;
+}
+
+void VoiceManager::setClipLimit(const std::shared_ptr<Mona::AudioClip>& clip, int maxVoices) {
+	mClipLimits[clip.get()] = maxVoices;
+}
+
+float VoiceManager::computeAudibility(const glm::vec3& position, float volume) const {
+	if (!mHasListener) return volume;
+
+	// Atenuación por distancia inversa, igual a la que usa OpenAL por defecto
+	float distance = glm::length(position - mListener->GetLocalTranslation());
+	return volume * mReferenceDistance / std::max(mReferenceDistance, distance);
+}
+
+bool VoiceManager::isQuieter(const Voice& voice, VoicePriority priority, float audibility) const {
+	// La prioridad manda; la audibilidad solo desempata dentro de la misma prioridad
+	if (voice.priority != priority) return voice.priority < priority;
+	return voice.audibility < audibility;
+}
+
+int VoiceManager::findVoiceToUse(const Mona::AudioClip* clip, VoicePriority priority, float audibility) const {
+	auto limit = mClipLimits.find(clip);
+	if (limit != mClipLimits.end()) {
+		int playing = 0;
+		int quietest = -1;
+		for (size_t i = 0; i < mVoices.size(); i++) {
+			if (!mVoices[i].active || mVoices[i].clip != clip) continue;
+			playing++;
+			if (quietest < 0 || isQuieter(mVoices[i], mVoices[quietest].priority, mVoices[quietest].audibility)) quietest = static_cast<int>(i);
+		}
+		// Con el clip en su límite solo se puede reemplazar una voz del mismo clip
+		if (playing >= limit->second) {
+			if (quietest >= 0 && isQuieter(mVoices[quietest], priority, audibility)) return quietest;
+			return -1;
+		}
+	}
+
+	int quietest = -1;
+	for (size_t i = 0; i < mVoices.size(); i++) {
+		if (!mVoices[i].active) return static_cast<int>(i);
+		if (quietest < 0 || isQuieter(mVoices[i], mVoices[quietest].priority, mVoices[quietest].audibility)) quietest = static_cast<int>(i);
+	}
+	if (quietest >= 0 && isQuieter(mVoices[quietest], priority, audibility)) return quietest;
+	return -1;
+}
+
+void VoiceManager::stopVoice(Voice& voice) {
+	voice.source->Stop();
+	voice.active = false;
+	voice.clip = nullptr;
+}
+
+bool VoiceManager::playClip3D(const std::shared_ptr<Mona::AudioClip>& clip, const glm::vec3& position, float volume, VoicePriority priority) {
+	if (clip == nullptr) return false;
+
+	float audibility = computeAudibility(position, volume);
+	// Sonidos lejanos y poco importantes ni siquiera compiten por una voz
+	if (audibility < mCullThreshold && priority < VoicePriority::High) return false;
+
+	int index = findVoiceToUse(clip.get(), priority, audibility);
+	if (index < 0) return false;
+
+	Voice& voice = mVoices[index];
+	if (voice.active) stopVoice(voice);
+
+	voice.clip = clip.get();
+	voice.position = position;
+	voice.volume = volume;
+	voice.remaining = clip->GetTotalTime();
+	voice.audibility = audibility;
+	voice.priority = priority;
+	voice.active = true;
+
+	voice.transform->SetTranslation(position);
+	voice.source->SetAudioClip(clip);
+	voice.source->SetVolume(volume);
+	voice.source->Play();
+	return true;
+}
@@ -0,0 +1,150 @@
+// FlowField sobre una pista sintética de quads: las direcciones tienen que llevar a la meta, un
+// obstáculo tiene que encarecer las celdas cercanas y, una vez consumido, refresh tiene que dejar el
+// campo igual que un build completo sin él. Los riders de la CPU vienen apagados por defecto, así que
+// este test es lo único que ejercita el campo.
+
+#include "flow_field.h"
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+// Obstáculo mínimo: solo posición, peso y radio; nunca se dibuja ni toca a nadie
+class TestObstacle : public CourseObject {
+public:
+	TestObstacle(const glm::vec3& position, float weight, float radius) : mPosition(position), mWeight(weight), mRadius(radius) {}
+
+	glm::vec3 getCoursePosition() const override { return mPosition; }
+	int findContact(const std::vector<glm::vec3>& riderPositions) const override { return -1; }
+	void applyContact(Mona::World& world, Mona::GameObjectHandle<Player>& rider) override {}
+	bool isConsumed() const override { return mConsumed; }
+	void setConsumed(bool consumed) override { mConsumed = consumed; }
+	float getSteeringWeight() const override { return mWeight; }
+	float getSteeringRadius() const override { return mRadius; }
+
+private:
+	glm::vec3 mPosition;
+	float mWeight;
+	float mRadius;
+	bool mConsumed = false;
+};
+
+static const int courseWidth = 20;      // x entre -10 y 10
+static const int courseLength = 60;     // z entre 0 y -60
+static const float courseSlope = 0.2f;  // baja hacia -z
+static const float finishZ = -50.0f;
+
+// Grilla de quads de 1 x 1 que baja hacia -z, como la pista de verdad
+static void writeCourse(const std::filesystem::path& path) {
+	std::ofstream obj(path);
+	for (int z = 0; z <= courseLength; z++) {
+		for (int x = 0; x <= courseWidth; x++) {
+			obj << "v " << x - courseWidth / 2 << " " << -z * courseSlope << " " << -z << "\n";
+		}
+	}
+	int row = courseWidth + 1;
+	for (int z = 0; z < courseLength; z++) {
+		for (int x = 0; x < courseWidth; x++) {
+			int v = z * row + x + 1;
+			obj << "f " << v << " " << v + row << " " << v + row + 1 << " " << v + 1 << "\n";
+		}
+	}
+}
+
+int main() {
+	std::filesystem::path course = std::filesystem::temp_directory_path() / "flow_field_test_course.obj";
+	writeCourse(course);
+	MeshNavigator navigator(course.string(), 1.0f);
+	navigator.loadMeshToMap(course.string());
+
+	int failures = 0;
+	const glm::vec3 obstaclePosition(0.0f, 0.0f, -25.0f);
+
+	FlowField clear(1.0f, finishZ);
+	clear.build(navigator);
+	if (!clear.isBuilt()) {
+		std::cout << "the field did not build over the synthetic course" << std::endl;
+		std::filesystem::remove(course);
+		return 1;
+	}
+
+	// Sin obstáculos toda celda antes de la meta baja hacia -z
+	int directionErrors = 0;
+	for (int z = 0; z < clear.getDepth(); z++) {
+		for (int x = 0; x < clear.getWidth(); x++) {
+			float cx = -courseWidth / 2 + x + 0.5f;
+			float cz = -courseLength + z + 0.5f;
+			if (cz < finishZ) continue;
+			glm::vec2 direction;
+			if (!clear.getDirection(cx, cz, direction)) {
+				std::cout << "no direction at (" << cx << ", " << cz << ")" << std::endl;
+				directionErrors++;
+			}
+			else if (direction.y > -0.7f) {
+				std::cout << "direction at (" << cx << ", " << cz << ") is (" << direction.x << ", " << direction.y << "), not toward the finish" << std::endl;
+				directionErrors++;
+			}
+		}
+	}
+	failures += directionErrors;
+
+	// El obstáculo encarece las celdas de su zona y aparta las direcciones de él
+	TestObstacle obstacle(obstaclePosition, 4.0f, 3.0f);
+	FlowField blocked(1.0f, finishZ);
+	blocked.addObject(&obstacle);
+	blocked.build(navigator);
+	for (float dx : { -1.5f, 0.5f, 1.5f }) {
+		float x = obstaclePosition.x + dx;
+		float z = obstaclePosition.z + 0.5f;
+		if (!(blocked.getCost(x, z) > clear.getCost(x, z))) {
+			std::cout << "cost at (" << x << ", " << z << ") is " << blocked.getCost(x, z) << " with the obstacle and " << clear.getCost(x, z) << " without it" << std::endl;
+			failures++;
+		}
+	}
+	glm::vec2 left, right;
+	if (blocked.getDirection(obstaclePosition.x - 1.5f, obstaclePosition.z + 3.5f, left) && blocked.getDirection(obstaclePosition.x + 1.5f, obstaclePosition.z + 3.5f, right)) {
+		if (!(left.x < 0.0f && right.x > 0.0f)) {
+			std::cout << "directions before the obstacle do not go around it: left (" << left.x << ", " << left.y << "), right (" << right.x << ", " << right.y << ")" << std::endl;
+			failures++;
+		}
+	}
+	else {
+		std::cout << "no direction before the obstacle" << std::endl;
+		failures++;
+	}
+
+	// Consumido, refresh solo rehace su zona y tiene que dar lo mismo que armar el campo sin él
+	obstacle.setConsumed(true);
+	size_t repaired = blocked.refresh();
+	if (repaired == 0) {
+		std::cout << "refresh did not recompute any cell after the obstacle was consumed" << std::endl;
+		failures++;
+	}
+	FlowField rebuilt(1.0f, finishZ);
+	rebuilt.addObject(&obstacle);
+	rebuilt.build(navigator);
+	int mismatches = 0;
+	for (int z = 0; z < rebuilt.getDepth(); z++) {
+		for (int x = 0; x < rebuilt.getWidth(); x++) {
+			float cx = -courseWidth / 2 + x + 0.5f;
+			float cz = -courseLength + z + 0.5f;
+			glm::vec2 repairedDirection(0.0f), rebuiltDirection(0.0f);
+			bool hasRepaired = blocked.getDirection(cx, cz, repairedDirection);
+			bool hasRebuilt = rebuilt.getDirection(cx, cz, rebuiltDirection);
+			float costError = std::abs(blocked.getCost(cx, cz) - rebuilt.getCost(cx, cz));
+			if (hasRepaired != hasRebuilt || glm::length(repairedDirection - rebuiltDirection) > 1e-4f || !(costError <= 1e-3f)) {
+				if (mismatches < 10) {
+					std::cout << "cell (" << cx << ", " << cz << ") after refresh: cost " << blocked.getCost(cx, cz) << ", direction (" << repairedDirection.x << ", " << repairedDirection.y
+						<< "); full build: cost " << rebuilt.getCost(cx, cz) << ", direction (" << rebuiltDirection.x << ", " << rebuiltDirection.y << ")" << std::endl;
+				}
+				mismatches++;
+			}
+		}
+	}
+	failures += mismatches;
+
+	std::filesystem::remove(course);
+	if (failures > 0) return 1;
+	std::cout << "flow field leads to the finish, avoids the obstacle and refresh matches a full build (" << repaired << " cells repaired)" << std::endl;
+	return 0;
+}
@@ -0,0 +1,153 @@
+// Las fases de BasicPhaseRunner corren en orden fijo sin importar en qué orden se agregaron las tareas,
+// cada ítem paralelo corre una sola vez y una tarea serial ve terminados los ítems anteriores de su
+// fase. Con eso los triggers de un frame siempre ven las posiciones de ese mismo frame, igual que
+// simulando en serie. Usa un contexto propio en vez del World.
+
+#include "frame_scheduler.h"
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+struct TestContext {
+	std::vector<FramePhase> phaseLog;
+};
+
+// Gameplay de juguete con la misma forma que el de main: input por rider, simulación paralela,
+// contactos paralelos contra las posiciones del frame y efectos en serie
+struct ToyRace {
+	static constexpr int gateCount = 16;
+
+	std::vector<float> positions;
+	std::vector<float> inputs;
+	std::vector<int> contacts;       // rider que toca cada gate en este frame, -1 si ninguno
+	std::vector<bool> consumed;
+	std::vector<int> winners;        // quién consumió cada gate
+
+	explicit ToyRace(int riders) : positions(riders, 0.0f), inputs(riders, 0.0f), contacts(gateCount, -1), consumed(gateCount, false), winners(gateCount, -1) {}
+
+	void readInput(int rider, int frame) { inputs[rider] = 0.5f + 0.1f * ((rider * 7 + frame) % 5); }
+	void simulate(int rider, float timeStep) { positions[rider] += inputs[rider] * timeStep * 60.0f; }
+	static float gatePosition(int gate) { return 10.0f + gate * 7.5f; }
+	void findContact(int gate) {
+		contacts[gate] = -1;
+		if (consumed[gate]) return;
+		for (size_t r = 0; r < positions.size(); r++) {
+			if (positions[r] >= gatePosition(gate) && positions[r] < gatePosition(gate) + 1.0f) {
+				contacts[gate] = static_cast<int>(r);
+				return;
+			}
+		}
+	}
+	void applyContacts() {
+		for (int gate = 0; gate < gateCount; gate++) {
+			if (contacts[gate] < 0) continue;
+			consumed[gate] = true;
+			winners[gate] = contacts[gate];
+			positions[contacts[gate]] -= 0.25f;     // el efecto mueve al rider: se nota si llega tarde o dos veces
+		}
+	}
+};
+
+int main() {
+	const float timeStep = 1.0f / 60.0f;
+	const int riders = 300;
+	const int frames = 240;
+	int failures = 0;
+
+	// Fases agregadas al revés: el orden tiene que salir de FramePhase, no del registro
+	{
+		BasicPhaseRunner<TestContext> runner;
+		for (int phase = static_cast<int>(FramePhase::Count) - 1; phase >= 0; phase--) {
+			FramePhase p = static_cast<FramePhase>(phase);
+			runner.addTask(p, [p](TestContext& context, float) { context.phaseLog.push_back(p); });
+		}
+		TestContext context;
+		runner.runFrame(context, timeStep);
+		bool ordered = context.phaseLog.size() == static_cast<size_t>(FramePhase::Count);
+		for (size_t i = 0; ordered && i < context.phaseLog.size(); i++) {
+			ordered = context.phaseLog[i] == static_cast<FramePhase>(i);
+		}
+		if (!ordered) {
+			std::cout << "phases did not run in FramePhase order" << std::endl;
+			failures++;
+		}
+	}
+
+	// Dos tareas paralelas seguidas se juntan; la serial que sigue hace de barrera
+	{
+		const size_t itemsA = 5000, itemsB = 3001;
+		std::unique_ptr<std::atomic<int>[]> runsA(new std::atomic<int>[itemsA]);
+		std::unique_ptr<std::atomic<int>[]> runsB(new std::atomic<int>[itemsB]);
+		for (size_t i = 0; i < itemsA; i++) runsA[i] = 0;
+		for (size_t i = 0; i < itemsB; i++) runsB[i] = 0;
+		size_t seenAtBarrier = 0;
+
+		BasicPhaseRunner<TestContext> runner;
+		runner.addParallelTask(FramePhase::Simulation, [&]() { return itemsA; }, [&](size_t i, float) { runsA[i]++; }, 64);
+		runner.addParallelTask(FramePhase::Simulation, [&]() { return itemsB; }, [&](size_t i, float) { runsB[i]++; }, 16);
+		runner.addTask(FramePhase::Simulation, [&](TestContext&, float) {
+			for (size_t i = 0; i < itemsA; i++) seenAtBarrier += runsA[i].load();
+			for (size_t i = 0; i < itemsB; i++) seenAtBarrier += runsB[i].load();
+		});
+		TestContext context;
+		runner.runFrame(context, timeStep);
+
+		bool once = true;
+		for (size_t i = 0; i < itemsA; i++) once = once && runsA[i] == 1;
+		for (size_t i = 0; i < itemsB; i++) once = once && runsB[i] == 1;
+		if (!once) {
+			std::cout << "a parallel item ran zero or several times" << std::endl;
+			failures++;
+		}
+		if (seenAtBarrier != itemsA + itemsB) {
+			std::cout << "serial task saw " << seenAtBarrier << " of " << itemsA + itemsB << " items finished" << std::endl;
+			failures++;
+		}
+		if (runner.getStats(FramePhase::Simulation).items != itemsA + itemsB) {
+			std::cout << "Simulation stats report " << runner.getStats(FramePhase::Simulation).items << " items" << std::endl;
+			failures++;
+		}
+	}
+
+	// Gameplay agregado en desorden contra la misma carrera simulada en serie
+	{
+		ToyRace reference(riders);
+		for (int frame = 0; frame < frames; frame++) {
+			for (int r = 0; r < riders; r++) reference.readInput(r, frame);
+			for (int r = 0; r < riders; r++) reference.simulate(r, timeStep);
+			for (int g = 0; g < ToyRace::gateCount; g++) reference.findContact(g);
+			reference.applyContacts();
+		}
+
+		ToyRace race(riders);
+		int frame = 0;
+		BasicPhaseRunner<TestContext> runner;
+		runner.addTask(FramePhase::Events, [&](TestContext&, float) { race.applyContacts(); });
+		runner.addParallelTask(FramePhase::Triggers, []() { return static_cast<size_t>(ToyRace::gateCount); },
+			[&](size_t g, float) { race.findContact(static_cast<int>(g)); }, 2);
+		runner.addParallelTask(FramePhase::Simulation, [&]() { return race.positions.size(); },
+			[&](size_t r, float step) { race.simulate(static_cast<int>(r), step); }, 32);
+		runner.addParallelTask(FramePhase::Input, [&]() { return race.positions.size(); },
+			[&](size_t r, float) { race.readInput(static_cast<int>(r), frame); }, 32);
+		runner.addTask(FramePhase::Presentation, [&](TestContext&, float) { frame++; });
+
+		TestContext context;
+		for (int f = 0; f < frames; f++) runner.runFrame(context, timeStep);
+
+		if (race.positions != reference.positions || race.winners != reference.winners) {
+			std::cout << "scheduled race differs from the serial one" << std::endl;
+			failures++;
+		}
+		int gatesTaken = 0;
+		for (bool taken : reference.consumed) gatesTaken += taken ? 1 : 0;
+		if (gatesTaken == 0) {
+			std::cout << "no gate was consumed, the race test checks nothing" << std::endl;
+			failures++;
+		}
+	}
+
+	if (failures > 0) return 1;
+	std::cout << "phases ran in order with " << ThreadPool::GetInstance().getWorkerCount() << " threads" << std::endl;
+	return 0;
+}
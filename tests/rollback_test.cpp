@@ -0,0 +1,163 @@
+// Dos RollbackCore conectados por LoopbackPeer con latencia, jitter y pérdida: cada uno predice el input
+// del otro y corrige con rollback, así que una vez confirmados los inputs los dos deben tener el mismo
+// estado, bit a bit, en cada tick. El juego es sintético para no necesitar World.
+
+#include "rollback_session.h"
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+// Dos riders que se mueven en XZ según su input y una fila de triggers que se consumen al pasar cerca y
+// empujan al rider que los tocó. Los riders se guardan en orden fijo (no local/remoto), así que los dos
+// lados del test producen snapshots comparables.
+class TestGame : public RollbackGame {
+public:
+	static constexpr int triggerCount = 24;
+
+	TestGame(int localSlot, uint32_t seed) : mLocalSlot(localSlot), mSeed(seed) {
+		for (int i = 0; i < GameSnapshot::maxRiders; i++) {
+			mRiders[i] = PlayerState();
+			mRiders[i].position = glm::vec3(i * 2.0f, 0.0f, 0.0f);
+			mRiders[i].velocity = glm::vec3(0.0f);
+		}
+		mHistory.push_back(current());
+	}
+
+	PlayerInput readLocalInput() override {
+		// Cambia cada pocos ticks para que la predicción del otro lado falle seguido
+		uint32_t phase = (mInputTick++ * 2654435761u ^ mSeed) >> 28;
+		PlayerInput input;
+		input.steer = static_cast<int8_t>(static_cast<int>(phase % 3) - 1);
+		if (phase & 4) input.buttons |= PlayerInput::Accelerate;
+		if (phase == 15) input.buttons |= PlayerInput::Brake;
+		return input;
+	}
+
+	void saveState(GameSnapshot& snapshot) const override {
+		snapshot.consumedTriggers = mConsumed;
+		for (int i = 0; i < GameSnapshot::maxRiders; i++) snapshot.riders[i] = mRiders[i];
+	}
+
+	void restoreState(const GameSnapshot& snapshot) override {
+		mTick = snapshot.tick;
+		mConsumed = snapshot.consumedTriggers;
+		for (int i = 0; i < GameSnapshot::maxRiders; i++) mRiders[i] = snapshot.riders[i];
+	}
+
+	void simulateTick(const PlayerInput& local, const PlayerInput& remote, float timeStep) override {
+		if (mResimulating) mResimulatedTicks++;
+		PlayerInput inputs[GameSnapshot::maxRiders];
+		inputs[mLocalSlot] = local;
+		inputs[1 - mLocalSlot] = remote;
+		for (int i = 0; i < GameSnapshot::maxRiders; i++) {
+			PlayerState& rider = mRiders[i];
+			float forward = (inputs[i].buttons & PlayerInput::Accelerate) ? 6.0f : 1.5f;
+			if (inputs[i].buttons & PlayerInput::Brake) forward = -4.0f;
+			rider.velocity.x += inputs[i].steer * 3.0f * timeStep;
+			rider.velocity.z -= forward * timeStep;
+			rider.velocity *= 0.99f;
+			rider.position += rider.velocity * timeStep;
+		}
+		for (int t = 0; t < triggerCount; t++) {
+			if (mConsumed[t]) continue;
+			glm::vec3 trigger((t % 3 - 1) * 1.5f, 0.0f, -4.0f - t * 3.0f);
+			for (int i = 0; i < GameSnapshot::maxRiders; i++) {
+				glm::vec3 offset = mRiders[i].position - trigger;
+				if (offset.x * offset.x + offset.z * offset.z > 1.5f * 1.5f) continue;
+				mConsumed.set(t);
+				mRiders[i].velocity.z -= 2.0f;
+				break;
+			}
+		}
+
+		mTick++;
+		if (mHistory.size() <= mTick) mHistory.resize(mTick + 1);
+		mHistory[mTick] = current();
+	}
+
+	void beginResimulation() override { mResimulating = true; }
+	void endResimulation() override { mResimulating = false; }
+
+	struct TickState {
+		PlayerState riders[GameSnapshot::maxRiders];
+		CourseActivation::TriggerMask consumed;
+	};
+	// Estado al terminar cada tick; los ticks re-simulados se sobrescriben
+	const std::vector<TickState>& getHistory() const { return mHistory; }
+	uint64_t getResimulatedTicks() const { return mResimulatedTicks; }
+
+private:
+	TickState current() const {
+		TickState state;
+		for (int i = 0; i < GameSnapshot::maxRiders; i++) state.riders[i] = mRiders[i];
+		state.consumed = mConsumed;
+		return state;
+	}
+
+	int mLocalSlot;
+	uint32_t mSeed;
+	uint32_t mInputTick = 0;
+	uint32_t mTick = 0;
+	bool mResimulating = false;
+	uint64_t mResimulatedTicks = 0;
+
+	PlayerState mRiders[GameSnapshot::maxRiders];
+	CourseActivation::TriggerMask mConsumed;
+	std::vector<TickState> mHistory;
+};
+
+static bool sameRider(const PlayerState& a, const PlayerState& b) {
+	return std::memcmp(&a.position, &b.position, sizeof(a.position)) == 0 &&
+		std::memcmp(&a.velocity, &b.velocity, sizeof(a.velocity)) == 0;
+}
+
+int main() {
+	const float timeStep = 1.0f / 60.0f;
+	const uint32_t ticks = 900;
+
+	LoopbackPeer toB(60.0f, 30.0f, 0.15f, 11);
+	LoopbackPeer toA(45.0f, 40.0f, 0.2f, 23);
+	TestGame gameA(0, 0x1234u);
+	TestGame gameB(1, 0xBEEFu);
+	RollbackCore sessionA(&gameA, &toB, &toA, 60.0f, 12);
+	RollbackCore sessionB(&gameB, &toA, &toB, 60.0f, 12);
+
+	int frames = 0;
+	while (sessionA.getConfirmedTick() < ticks || sessionB.getConfirmedTick() < ticks) {
+		sessionA.advance(timeStep);
+		sessionB.advance(timeStep);
+		if (++frames > 20 * static_cast<int>(ticks)) {
+			std::cout << "sessions stopped confirming at ticks " << sessionA.getConfirmedTick() << " and " << sessionB.getConfirmedTick() << std::endl;
+			return 1;
+		}
+	}
+
+	int failures = 0;
+	const auto& historyA = gameA.getHistory();
+	const auto& historyB = gameB.getHistory();
+	for (uint32_t t = 1; t <= ticks; t++) {
+		bool riders = sameRider(historyA[t].riders[0], historyB[t].riders[0]) && sameRider(historyA[t].riders[1], historyB[t].riders[1]);
+		bool consumed = historyA[t].consumed == historyB[t].consumed;
+		if (riders && consumed) continue;
+		if (failures++ < 5) {
+			std::cout << "tick " << t << ": sessions diverged (" << (riders ? "" : "rider state ") << (consumed ? "" : "consumed triggers") << ")" << std::endl;
+		}
+	}
+
+	// Sin pérdidas ni rollbacks el test no probaría nada
+	if (toA.getDroppedCount() == 0 || toB.getDroppedCount() == 0 || sessionA.getStats().rollbacks == 0 || sessionB.getStats().rollbacks == 0) {
+		std::cout << "the peers never dropped a packet or the sessions never rolled back" << std::endl;
+		failures++;
+	}
+	if (historyA[ticks].consumed.none()) {
+		std::cout << "no trigger was consumed" << std::endl;
+		failures++;
+	}
+
+	std::cout << "A: " << sessionA.getStats().rollbacks << " rollbacks, " << gameA.getResimulatedTicks() << " ticks re-simulated; B: "
+		<< sessionB.getStats().rollbacks << " rollbacks, " << gameB.getResimulatedTicks() << " ticks re-simulated; "
+		<< historyA[ticks].consumed.count() << " triggers consumed" << std::endl;
+	if (failures > 0) return 1;
+	std::cout << "both sessions agree on every confirmed tick" << std::endl;
+	return 0;
+}
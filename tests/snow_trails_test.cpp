@@ -0,0 +1,52 @@
+// Un rider detenido o lento sobre la nieve no debe quedar en el aire por el surco que él mismo deja:
+// entre un frame y el siguiente el suelo bajo él no puede bajar más que Player::groundThreshold.
+// Solo usa SnowDeformation y TrailStamper, sin World ni GameObjects.
+
+#include "snow_trails.h"
+#include <iostream>
+
+// Sigue al suelo como lo hace Player::simulate: si el suelo baja más que groundThreshold bajo el
+// rider, este queda en el aire. Retorna la cantidad de frames en que eso pasó.
+static int rideOverTrail(const char* name, const glm::vec3& start, const glm::vec3& velocity, float depth) {
+	SnowDeformation deformation;
+	TrailStamper stamper(&deformation, 0.6f, depth);
+
+	const float timeStep = 1.0f / 60.0f;
+	int failures = 0;
+	glm::vec3 position = start;
+	for (int frame = 0; frame < 120; frame++) {
+		float before = deformation.getHeightDelta(position.x, position.z);
+		stamper.advance(position, true);
+		float after = deformation.getHeightDelta(position.x, position.z);
+		if (before - after > Player::groundThreshold) {
+			std::cout << name << ", frame " << frame << ": ground dropped " << before - after << " under the rider" << std::endl;
+			failures++;
+		}
+		if (!(after <= 0.0f && after >= -TrailStamper::maxDepth)) {
+			std::cout << name << ", frame " << frame << ": groove is " << after << ", expected between " << -TrailStamper::maxDepth << " and 0" << std::endl;
+			failures++;
+		}
+
+		// El rider se mueve y el suelo nuevo bajo él tampoco puede quedar más abajo que el umbral
+		glm::vec3 next = position + velocity * timeStep;
+		float ahead = deformation.getHeightDelta(next.x, next.z);
+		if (after - ahead > Player::groundThreshold) {
+			std::cout << name << ", frame " << frame << ": stepping into the groove drops " << after - ahead << std::endl;
+			failures++;
+		}
+		position = next;
+	}
+	return failures;
+}
+
+int main() {
+	int failures = 0;
+	// Más hondo que Player::groundThreshold a propósito: TrailStamper tiene que limitarlo
+	failures += rideOverTrail("stationary", glm::vec3(0.0f), glm::vec3(0.0f), 0.12f);
+	failures += rideOverTrail("slow", glm::vec3(0.0f), glm::vec3(0.5f, 0.0f, -0.3f), 0.12f);
+	failures += rideOverTrail("fast", glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -25.0f), 0.12f);
+
+	if (failures > 0) return 1;
+	std::cout << "riders stayed on the ground over their own trail" << std::endl;
+	return 0;
+}
@@ -0,0 +1,418 @@
+// Valida la cobertura del terreno: muestrea toda la huella de la pista en una grilla fina, en paralelo,
+// y reporta hoyos, caras superpuestas, quads empinados o degenerados y el costo de las consultas por región.
+//
+// Uso: CourseValidator <terreno.obj> [--scale 50] [--step 0.25] [--steep 60] [--out course_report]
+
+#include "mesh_navigator.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+struct Options {
+	std::string filename;
+	float scale = 50.0f;
+	float step = 0.25f;
+	float steepDegrees = 60.0f;
+	std::string out = "course_report";
+};
+
+enum QuadFlags : uint8_t {
+	QuadDegenerate = 1 << 0,   // área nula en XZ o plano casi vertical: getHeightAt lanza o da basura
+	QuadSteep = 1 << 1,
+	QuadNonPlanar = 1 << 2
+};
+
+enum SampleFlags : uint8_t {
+	SampleCovered = 1 << 0,     // algún quad contiene el punto
+	SampleHole = 1 << 1,
+	SampleOverlap = 1 << 2,     // dos o más quads lo contienen con holgura
+	SampleWrongQuad = 1 << 3,   // la consulta retorna un quad que no contiene el punto (o ninguno) habiendo uno que sí
+	SampleThrows = 1 << 4,      // la consulta lanza una excepción
+	SampleSteep = 1 << 5,
+	SampleDegenerate = 1 << 6
+};
+
+struct BlockStats {
+	double nanosPerQuery = 0.0;
+	uint32_t covered = 0;
+	uint32_t overlaps = 0;
+	uint32_t wrongQuads = 0;
+	uint32_t throws = 0;
+};
+
+static const int blockSize = 32;   // muestras por lado de cada región de costo
+
+static bool parseOptions(int argc, char** argv, Options& options) {
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (arg == "--scale" && hasValue) options.scale = std::stof(argv[++i]);
+		else if (arg == "--step" && hasValue) options.step = std::stof(argv[++i]);
+		else if (arg == "--steep" && hasValue) options.steepDegrees = std::stof(argv[++i]);
+		else if (arg == "--out" && hasValue) options.out = argv[++i];
+		else if (arg[0] != '-' && options.filename.empty()) options.filename = arg;
+		else return false;
+	}
+	return !options.filename.empty() && options.step > 0.0f;
+}
+
+static float quadAreaXZ(const Quad& quad) {
+	const glm::vec3* v[4] = { &quad.v0, &quad.v1, &quad.v2, &quad.v3 };
+	float area = 0.0f;
+	for (int i = 0; i < 4; i++) {
+		const glm::vec3& a = *v[i];
+		const glm::vec3& b = *v[(i + 1) % 4];
+		area += a.x * b.z - b.x * a.z;
+	}
+	return 0.5f * std::abs(area);
+}
+
+static uint8_t classifyQuad(const Quad& quad, float steepCos, float planarTolerance) {
+	uint8_t flags = 0;
+	glm::vec3 planeNormal = glm::cross(quad.v1 - quad.v0, quad.v2 - quad.v0);
+	float planeLength = glm::length(planeNormal);
+	if (quadAreaXZ(quad) < 1e-6f || planeLength < 1e-9f || std::abs(planeNormal.y / planeLength) < 1e-4f) {
+		return QuadDegenerate;
+	}
+	planeNormal /= planeLength;
+	if (std::abs(glm::dot(quad.v3 - quad.v0, planeNormal)) > planarTolerance) flags |= QuadNonPlanar;
+
+	glm::vec3 normal = quad.calculateQuadNormal();
+	if (!std::isfinite(normal.y)) return flags | QuadDegenerate;
+	if (std::abs(normal.y) < steepCos) flags |= QuadSteep;
+	return flags;
+}
+
+// Distancia con signo al borde del triángulo en XZ, positiva hacia adentro
+static float triangleMargin(float px, float pz, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c) {
+	float orientation = (b.x - a.x) * (c.z - a.z) - (b.z - a.z) * (c.x - a.x) >= 0.0f ? 1.0f : -1.0f;
+	const glm::vec3* v[3] = { &a, &b, &c };
+	float margin = std::numeric_limits<float>::max();
+	for (int i = 0; i < 3; i++) {
+		const glm::vec3& e0 = *v[i];
+		const glm::vec3& e1 = *v[(i + 1) % 3];
+		float ex = e1.x - e0.x;
+		float ez = e1.z - e0.z;
+		float length = std::sqrt(ex * ex + ez * ez);
+		if (length == 0.0f) return -std::numeric_limits<float>::max();
+		margin = std::min(margin, orientation * (ex * (pz - e0.z) - ez * (px - e0.x)) / length);
+	}
+	return margin;
+}
+
+static float quadMargin(float x, float z, const Quad& quad) {
+	return std::max(triangleMargin(x, z, quad.v0, quad.v1, quad.v2), triangleMargin(x, z, quad.v0, quad.v2, quad.v3));
+}
+
+// Azul (barato) a rojo (caro) pasando por verde
+static void costColor(float t, uint8_t rgb[3]) {
+	t = std::clamp(t, 0.0f, 1.0f);
+	rgb[0] = static_cast<uint8_t>(255.0f * std::clamp(2.0f * t - 1.0f, 0.0f, 1.0f));
+	rgb[1] = static_cast<uint8_t>(255.0f * (1.0f - std::abs(2.0f * t - 1.0f)));
+	rgb[2] = static_cast<uint8_t>(255.0f * std::clamp(1.0f - 2.0f * t, 0.0f, 1.0f));
+}
+
+// BMP de 24 bits sin compresión; pixels en RGB, fila 0 arriba
+static bool writeBmp(const std::string& filename, int width, int height, const std::vector<uint8_t>& pixels) {
+	std::ofstream file(filename, std::ios::binary);
+	if (!file) return false;
+
+	int rowBytes = (width * 3 + 3) & ~3;
+	uint32_t dataSize = static_cast<uint32_t>(rowBytes) * height;
+	auto put16 = [&file](uint16_t v) { file.put(static_cast<char>(v & 0xFF)); file.put(static_cast<char>(v >> 8)); };
+	auto put32 = [&put16](uint32_t v) { put16(static_cast<uint16_t>(v & 0xFFFF)); put16(static_cast<uint16_t>(v >> 16)); };
+
+	file.put('B'); file.put('M');
+	put32(54 + dataSize); put32(0); put32(54);
+	put32(40); put32(width); put32(height); put16(1); put16(24);
+	put32(0); put32(dataSize); put32(2835); put32(2835); put32(0); put32(0);
+
+	std::vector<char> row(rowBytes, 0);
+	for (int y = height - 1; y >= 0; y--) {
+		for (int x = 0; x < width; x++) {
+			const uint8_t* p = &pixels[(static_cast<size_t>(y) * width + x) * 3];
+			row[x * 3 + 0] = static_cast<char>(p[2]);
+			row[x * 3 + 1] = static_cast<char>(p[1]);
+			row[x * 3 + 2] = static_cast<char>(p[0]);
+		}
+		file.write(row.data(), rowBytes);
+	}
+	return static_cast<bool>(file);
+}
+
+
+int main(int argc, char** argv) {
+	Options options;
+	if (!parseOptions(argc, argv, options)) {
+		std::cout << "Usage: CourseValidator <terrain.obj> [--scale 50] [--step 0.25] [--steep 60] [--out course_report]" << std::endl;
+		return 1;
+	}
+
+	auto& pool = ThreadPool::GetInstance();
+	auto startTime = std::chrono::steady_clock::now();
+
+	// El navegador que usa el juego, con el backend elegido en CMake, más una grilla propia para
+	// recorrer todos los quads candidatos de cada punto
+	MeshNavigator navigator(options.filename, options.scale);
+	try {
+		navigator.loadMeshToMap(options.filename);
+	}
+	catch (const std::exception& e) {
+		std::cout << "Failed to load " << options.filename << ": " << e.what() << std::endl;
+		return 1;
+	}
+	const std::vector<Quad*>& quads = navigator.quads;
+	const QuadLoadReport& load = navigator.getLoadReport();
+	if (quads.empty()) {
+		std::cout << options.filename << " has no quads" << std::endl;
+		return 1;
+	}
+	GridNavBackend index;
+	index.build(quads);
+
+	// Clasificación de quads
+	std::vector<uint8_t> quadFlags(quads.size(), 0);
+	float steepCos = std::cos(glm::radians(options.steepDegrees));
+	float planarTolerance = 0.01f * options.scale;
+	pool.parallelFor(quads.size(), 4096, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) quadFlags[i] = classifyQuad(*quads[i], steepCos, planarTolerance);
+	});
+	size_t degenerateQuads = std::count_if(quadFlags.begin(), quadFlags.end(), [](uint8_t f) { return (f & QuadDegenerate) != 0; });
+	size_t steepQuads = std::count_if(quadFlags.begin(), quadFlags.end(), [](uint8_t f) { return (f & QuadSteep) != 0; });
+	size_t nonPlanarQuads = std::count_if(quadFlags.begin(), quadFlags.end(), [](uint8_t f) { return (f & QuadNonPlanar) != 0; });
+
+	// Las banderas de muestra necesitan el índice del quad; se busca con un mapa de puntero a índice ordenado
+	std::vector<std::pair<const Quad*, uint32_t>> quadIndex(quads.size());
+	for (uint32_t i = 0; i < quads.size(); i++) quadIndex[i] = { quads[i], i };
+	std::sort(quadIndex.begin(), quadIndex.end());
+	auto flagsOf = [&](const Quad* quad) {
+		auto it = std::lower_bound(quadIndex.begin(), quadIndex.end(), std::make_pair(quad, 0u));
+		return quadFlags[it->second];
+	};
+
+	// Grilla de muestras sobre la caja de la pista, recorrida por bloques de blockSize x blockSize
+	const QuadBoundsXZ& bounds = index.getCourseBounds();
+	int cols = static_cast<int>(std::ceil((bounds.maxx - bounds.minx) / options.step)) + 1;
+	int rows = static_cast<int>(std::ceil((bounds.maxz - bounds.minz) / options.step)) + 1;
+	int blockCols = (cols + blockSize - 1) / blockSize;
+	int blockRows = (rows + blockSize - 1) / blockSize;
+	size_t sampleCount = static_cast<size_t>(cols) * rows;
+	float strictMargin = 0.01f * options.step;
+
+	// Fila 0 en el extremo de mayor z, que es donde parte la pista
+	auto sampleX = [&](int c) { return bounds.minx + c * options.step; };
+	auto sampleZ = [&](int r) { return bounds.maxz - r * options.step; };
+
+	std::vector<uint8_t> sampleFlags(sampleCount, 0);
+	std::vector<float> heights(sampleCount, 0.0f);
+	std::vector<BlockStats> blocks(static_cast<size_t>(blockCols) * blockRows);
+
+	auto samplingStart = std::chrono::steady_clock::now();
+	pool.parallelFor(blocks.size(), 1, [&](size_t begin, size_t end) {
+		std::vector<Quad*> found(blockSize * blockSize);
+		std::vector<uint8_t> threw(blockSize * blockSize);
+		for (size_t b = begin; b < end; b++) {
+			int c0 = static_cast<int>(b % blockCols) * blockSize;
+			int r0 = static_cast<int>(b / blockCols) * blockSize;
+			int c1 = std::min(c0 + blockSize, cols);
+			int r1 = std::min(r0 + blockSize, rows);
+			BlockStats& stats = blocks[b];
+
+			// Primero solo las consultas del juego, para que el tiempo medido sea el de producción
+			auto queryStart = std::chrono::steady_clock::now();
+			for (int r = r0; r < r1; r++) {
+				for (int c = c0; c < c1; c++) {
+					int local = (r - r0) * blockSize + (c - c0);
+					GroundSample ground;
+					try {
+						found[local] = navigator.sampleGround(sampleX(c), sampleZ(r), ground) ? ground.quad : nullptr;
+						heights[static_cast<size_t>(r) * cols + c] = ground.height;
+						threw[local] = 0;
+					}
+					catch (const std::exception&) {
+						found[local] = nullptr;
+						threw[local] = 1;
+					}
+				}
+			}
+			double nanos = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - queryStart).count();
+			stats.nanosPerQuery = nanos / ((r1 - r0) * (c1 - c0));
+
+			// Después la validación contra todos los quads candidatos
+			for (int r = r0; r < r1; r++) {
+				for (int c = c0; c < c1; c++) {
+					int local = (r - r0) * blockSize + (c - c0);
+					float x = sampleX(c);
+					float z = sampleZ(r);
+					const Quad* containing = nullptr;
+					int strictCount = 0;
+					bool foundContains = false;
+					index.forEachCandidate(x, z, [&](const Quad* quad) {
+						float margin = quadMargin(x, z, *quad);
+						if (margin < -1e-5f) return;
+						if (containing == nullptr) containing = quad;
+						if (quad == found[local]) foundContains = true;
+						if (margin > strictMargin) strictCount++;
+					});
+
+					uint8_t flags = 0;
+					if (containing != nullptr) {
+						flags |= SampleCovered;
+						stats.covered++;
+						uint8_t qf = flagsOf(foundContains ? found[local] : containing);
+						if (qf & QuadSteep) flags |= SampleSteep;
+						if (qf & QuadDegenerate) flags |= SampleDegenerate;
+						if (!foundContains) {
+							flags |= SampleWrongQuad;
+							stats.wrongQuads++;
+						}
+					}
+					if (strictCount > 1) {
+						flags |= SampleOverlap;
+						stats.overlaps++;
+					}
+					if (threw[local]) {
+						flags |= SampleThrows;
+						stats.throws++;
+					}
+					sampleFlags[static_cast<size_t>(r) * cols + c] = flags;
+				}
+			}
+		}
+	});
+	double samplingSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - samplingStart).count();
+
+	// Hoyo: punto sin quad encerrado por muestras cubiertas en su fila y en su columna.
+	// Lo que queda fuera de esos rangos es el exterior de la pista, no un hoyo.
+	std::vector<int> rowFirst(rows, cols), rowLast(rows, -1), colFirst(cols, rows), colLast(cols, -1);
+	for (int r = 0; r < rows; r++) {
+		for (int c = 0; c < cols; c++) {
+			if (!(sampleFlags[static_cast<size_t>(r) * cols + c] & SampleCovered)) continue;
+			rowFirst[r] = std::min(rowFirst[r], c);
+			rowLast[r] = std::max(rowLast[r], c);
+			colFirst[c] = std::min(colFirst[c], r);
+			colLast[c] = std::max(colLast[c], r);
+		}
+	}
+	size_t holes = 0;
+	std::vector<std::pair<float, float>> holeExamples;
+	for (int r = 0; r < rows; r++) {
+		for (int c = rowFirst[r] + 1; c < rowLast[r]; c++) {
+			uint8_t& flags = sampleFlags[static_cast<size_t>(r) * cols + c];
+			if ((flags & SampleCovered) || r <= colFirst[c] || r >= colLast[c]) continue;
+			flags |= SampleHole;
+			holes++;
+			if (holeExamples.size() < 10) holeExamples.push_back({ sampleX(c), sampleZ(r) });
+		}
+	}
+
+	BlockStats total;
+	for (const BlockStats& block : blocks) {
+		total.covered += block.covered;
+		total.overlaps += block.overlaps;
+		total.wrongQuads += block.wrongQuads;
+		total.throws += block.throws;
+	}
+
+	// Costo solo de los bloques que tocan la pista; el exterior se descarta en la primera celda de la grilla
+	std::vector<size_t> courseBlocks;
+	for (size_t b = 0; b < blocks.size(); b++) {
+		if (blocks[b].covered > 0) courseBlocks.push_back(b);
+	}
+	std::sort(courseBlocks.begin(), courseBlocks.end(), [&](size_t a, size_t b) { return blocks[a].nanosPerQuery < blocks[b].nanosPerQuery; });
+	auto costAt = [&](double fraction) {
+		if (courseBlocks.empty()) return 0.0;
+		return blocks[courseBlocks[static_cast<size_t>(fraction * (courseBlocks.size() - 1))]].nanosPerQuery;
+	};
+	double costLow = costAt(0.05);
+	double costHigh = costAt(0.99);
+
+	// Imágenes: una muestra por pixel, reducidas si la grilla es más grande que maxImageSize
+	const int maxImageSize = 4096;
+	int stride = std::max(1, (std::max(cols, rows) + maxImageSize - 1) / maxImageSize);
+	int width = (cols + stride - 1) / stride;
+	int height = (rows + stride - 1) / stride;
+	float minHeight = std::numeric_limits<float>::max();
+	float maxHeight = std::numeric_limits<float>::lowest();
+	for (size_t i = 0; i < sampleCount; i++) {
+		if (!(sampleFlags[i] & SampleCovered)) continue;
+		minHeight = std::min(minHeight, heights[i]);
+		maxHeight = std::max(maxHeight, heights[i]);
+	}
+
+	std::vector<uint8_t> issuePixels(static_cast<size_t>(width) * height * 3);
+	std::vector<uint8_t> costPixels(static_cast<size_t>(width) * height * 3);
+	pool.parallelFor(height, 16, [&](size_t begin, size_t end) {
+		for (size_t y = begin; y < end; y++) {
+			for (int x = 0; x < width; x++) {
+				// El pixel toma el peor problema de las muestras que cubre
+				uint8_t combined = 0;
+				size_t first = static_cast<size_t>(y * stride) * cols + x * stride;
+				for (int dy = 0; dy < stride && y * stride + dy < static_cast<size_t>(rows); dy++) {
+					for (int dx = 0; dx < stride && x * stride + dx < cols; dx++) {
+						combined |= sampleFlags[first + static_cast<size_t>(dy) * cols + dx];
+					}
+				}
+
+				uint8_t* issue = &issuePixels[(y * width + x) * 3];
+				if (combined & SampleThrows) { issue[0] = 255; issue[1] = 255; issue[2] = 255; }
+				else if (combined & SampleHole) { issue[0] = 255; issue[1] = 0; issue[2] = 0; }
+				else if (combined & SampleWrongQuad) { issue[0] = 255; issue[1] = 0; issue[2] = 255; }
+				else if (combined & SampleOverlap) { issue[0] = 255; issue[1] = 255; issue[2] = 0; }
+				else if (combined & SampleDegenerate) { issue[0] = 0; issue[1] = 255; issue[2] = 255; }
+				else if (combined & SampleSteep) { issue[0] = 255; issue[1] = 128; issue[2] = 0; }
+				else if (combined & SampleCovered) {
+					float t = maxHeight > minHeight ? (heights[first] - minHeight) / (maxHeight - minHeight) : 0.5f;
+					uint8_t shade = static_cast<uint8_t>(60.0f + 140.0f * std::clamp(t, 0.0f, 1.0f));
+					issue[0] = shade; issue[1] = shade; issue[2] = shade;
+				}
+				else { issue[0] = 20; issue[1] = 20; issue[2] = 20; }
+
+				uint8_t* cost = &costPixels[(y * width + x) * 3];
+				const BlockStats& block = blocks[(y * stride / blockSize) * blockCols + (x * stride / blockSize)];
+				if (block.covered == 0) { cost[0] = 20; cost[1] = 20; cost[2] = 20; }
+				else costColor(static_cast<float>((block.nanosPerQuery - costLow) / std::max(costHigh - costLow, 1e-9)), cost);
+			}
+		}
+	});
+	bool imagesOk = writeBmp(options.out + "_issues.bmp", width, height, issuePixels);
+	imagesOk = writeBmp(options.out + "_cost.bmp", width, height, costPixels) && imagesOk;
+
+	double totalSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	double sampleArea = static_cast<double>(options.step) * options.step;
+
+	std::printf("Course: %s (scale %g, %s backend)\n", options.filename.c_str(), options.scale, SelectedNavBackend::name);
+	std::printf("Faces: %zu, quads: %zu, dropped: %zu not quads, %zu with NaN, %zu with bad indices (%zu malformed numbers)\n",
+		load.faces, load.quads, load.nonQuadFaces, load.nanFaces, load.badIndexFaces, load.malformedNumbers);
+	std::printf("Quads: %zu degenerate, %zu steeper than %g deg, %zu non planar\n", degenerateQuads, steepQuads, options.steepDegrees, nonPlanarQuads);
+	std::printf("Samples: %d x %d = %zu at %g m, %.2f s on %d threads (%.1f M samples/s)\n", cols, rows, sampleCount, options.step,
+		samplingSeconds, pool.getWorkerCount(), sampleCount / samplingSeconds / 1e6);
+	std::printf("Covered: %u samples (%.0f m2)\n", total.covered, total.covered * sampleArea);
+	std::printf("Holes: %zu samples (%.1f m2)\n", holes, holes * sampleArea);
+	for (const auto& hole : holeExamples) std::printf("    hole at (%.2f, %.2f)\n", hole.first, hole.second);
+	std::printf("Overlapping faces: %u samples\n", total.overlaps);
+	std::printf("Query returns a quad that does not contain the point: %u samples\n", total.wrongQuads);
+	std::printf("Query throws: %u samples\n", total.throws);
+	std::printf("Query cost per region (%dx%d samples): p5 %.1f ns, p50 %.1f ns, p99 %.1f ns\n", blockSize, blockSize, costLow, costAt(0.5), costHigh);
+	for (size_t i = 0; i < std::min<size_t>(5, courseBlocks.size()); i++) {
+		size_t b = courseBlocks[courseBlocks.size() - 1 - i];
+		int c = static_cast<int>(b % blockCols) * blockSize + blockSize / 2;
+		int r = static_cast<int>(b / blockCols) * blockSize + blockSize / 2;
+		std::printf("    %.1f ns around (%.1f, %.1f)\n", blocks[b].nanosPerQuery, sampleX(c), sampleZ(r));
+	}
+	if (imagesOk) std::printf("Heatmaps: %s_issues.bmp, %s_cost.bmp\n", options.out.c_str(), options.out.c_str());
+	else std::printf("Failed to write heatmaps to %s_*.bmp\n", options.out.c_str());
+	std::printf("Total: %.2f s\n", totalSeconds);
+
+	bool problems = holes > 0 || total.overlaps > 0 || total.wrongQuads > 0 || total.throws > 0 || degenerateQuads > 0 || load.dropped() > 0;
+	return problems ? 2 : 0;
+}